@@ -0,0 +1,311 @@
+// Micro-benchmarks for the math and geometry kernels in recognizer.c.
+// The kernels are compiled from recognizer.c itself, so the numbers are
+// for the code that actually ships. Optimized variants go in the
+// VARIANTS section and are checked against the scalar reference they
+// replace before they are timed.
+#define RECOGNIZER_NO_MAIN
+#include "recognizer.c"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#endif
+
+// --- SETTINGS ---
+#define BATCH 1024           // Elements per batch, about one baked mesh
+#define POLY_VERTS 10        // Largest part (the wings)
+#define POSE_GROUP 128       // Vectors sharing one pose, as a mesh's vertices do
+#define SAMPLES 31           // Timed samples per kernel
+#define MIN_SAMPLE_NS 2e5    // Batches are repeated until a sample is this long
+#define WARMUP_NS 5e7        // Per kernel, before sampling
+
+// --- INPUTS ---
+// Points span the model's bounding box; poses come from the real path, one
+// per POSE_GROUP consecutive vectors
+#define NUM_POSES (BATCH / POSE_GROUP)
+Vec3 inA[BATCH], inB[BATCH], inC[BATCH], inCentroid[BATCH], inFaceCenter[BATCH];
+float inPoly[BATCH * POLY_VERTS][4];
+float inStart[BATCH], inEnd[BATCH], inT[BATCH];
+float posePitch[NUM_POSES], poseYaw[NUM_POSES], poseRoll[NUM_POSES];
+Vec3 outRef[BATCH], outRun[BATCH];
+volatile float sink;
+
+float randRange(float lo, float hi)
+{
+  return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+Vec3 randPoint()
+{
+  Vec3 p = {randRange(-1.2f, 1.2f), randRange(-0.9f, 0.92f), randRange(-0.22f, 0.26f)};
+  return p;
+}
+
+void initInputs()
+{
+  srand(1982);
+  for (int i = 0; i < BATCH; i++)
+  {
+    inA[i] = randPoint();
+    inB[i] = randPoint();
+    inC[i] = randPoint();
+    inCentroid[i] = randPoint();
+    inFaceCenter[i] = randPoint();
+    inStart[i] = randRange(-5.0f, 5.0f);
+    inEnd[i] = randRange(-5.0f, 5.0f);
+    inT[i] = randRange(0.0f, 1.0f);
+  }
+  for (int p = 0; p < NUM_POSES; p++)
+  {
+    calculatePath((float)p * (MAX_FRAMES - 1) / NUM_POSES);
+    posePitch[p] = curPitch;
+    poseYaw[p] = curYaw;
+    poseRoll[p] = curRoll;
+  }
+  for (int i = 0; i < BATCH * POLY_VERTS; i++)
+  {
+    Vec3 p = randPoint();
+    inPoly[i][0] = p.x;
+    inPoly[i][1] = p.y;
+    inPoly[i][2] = 0.25f;
+    inPoly[i][3] = p.z;
+  }
+}
+
+// --- REFERENCE KERNELS ---
+// One batch each; every kernel writes one Vec3 per element
+
+void batchRotateVector(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+    out[i] = rotateVector(inA[i], posePitch[i / POSE_GROUP], poseYaw[i / POSE_GROUP], poseRoll[i / POSE_GROUP]);
+}
+
+void batchCalcOutwardNormal(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+    out[i] = calcOutwardNormal(inA[i], inB[i], inC[i], inCentroid[i], inFaceCenter[i]);
+}
+
+void batchNormalize(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+  {
+    out[i] = inA[i];
+    normalize(&out[i]);
+  }
+}
+
+void batchCrossProduct(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+    out[i] = crossProduct(inA[i], inB[i]);
+}
+
+void batchCalcCentroid(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+    out[i] = calcCentroid(&inPoly[i * POLY_VERTS], POLY_VERTS);
+}
+
+void batchLerp(Vec3 *out)
+{
+  for (int i = 0; i < BATCH; i++)
+  {
+    out[i].x = lerp(inStart[i], inEnd[i], inT[i]);
+    out[i].y = 0.0f;
+    out[i].z = 0.0f;
+  }
+}
+
+// --- VARIANTS ---
+
+// rotateVector with the pose hoisted: sin/cos and one fused 3x3 matrix per
+// pose, then 9 multiplies per vector, the way a whole mesh would be
+// transformed
+void batchRotateMatrix(Vec3 *out)
+{
+  for (int p = 0; p < NUM_POSES; p++)
+  {
+    float cp = cos(posePitch[p]), sp = sin(posePitch[p]);
+    float cy = cos(poseYaw[p]), sy = sin(poseYaw[p]);
+    float cr = cos(poseRoll[p]), sr = sin(poseRoll[p]);
+    // Roll * Yaw * Pitch, the order rotateVector applies them in reverse
+    float m[3][3] = {
+        {cr * cy, cr * sy * sp - sr * cp, cr * sy * cp + sr * sp},
+        {sr * cy, sr * sy * sp + cr * cp, sr * sy * cp - cr * sp},
+        {-sy, cy * sp, cy * cp},
+    };
+    for (int i = p * POSE_GROUP; i < (p + 1) * POSE_GROUP; i++)
+    {
+      Vec3 v = inA[i];
+      out[i].x = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z;
+      out[i].y = m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z;
+      out[i].z = m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z;
+    }
+  }
+}
+
+#ifdef __SSE__
+// normalize with the SSE reciprocal square root and one Newton step,
+// four vectors at a time; keeps the reference's short-vector guard
+void batchNormalizeRsqrt(Vec3 *out)
+{
+  const __m128 half = _mm_set1_ps(0.5f), three = _mm_set1_ps(3.0f);
+  const __m128 minLenSq = _mm_set1_ps(0.001f * 0.001f);
+  for (int i = 0; i < BATCH; i += 4)
+  {
+    __m128 x = _mm_set_ps(inA[i + 3].x, inA[i + 2].x, inA[i + 1].x, inA[i].x);
+    __m128 y = _mm_set_ps(inA[i + 3].y, inA[i + 2].y, inA[i + 1].y, inA[i].y);
+    __m128 z = _mm_set_ps(inA[i + 3].z, inA[i + 2].z, inA[i + 1].z, inA[i].z);
+    __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    __m128 r = _mm_rsqrt_ps(lenSq);
+    r = _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(three, _mm_mul_ps(_mm_mul_ps(lenSq, r), r)));
+    __m128 keep = _mm_cmpgt_ps(lenSq, minLenSq);
+    r = _mm_or_ps(_mm_and_ps(keep, r), _mm_andnot_ps(keep, _mm_set1_ps(1.0f)));
+    float ox[4], oy[4], oz[4];
+    _mm_storeu_ps(ox, _mm_mul_ps(x, r));
+    _mm_storeu_ps(oy, _mm_mul_ps(y, r));
+    _mm_storeu_ps(oz, _mm_mul_ps(z, r));
+    for (int k = 0; k < 4; k++)
+    {
+      out[i + k].x = ox[k];
+      out[i + k].y = oy[k];
+      out[i + k].z = oz[k];
+    }
+  }
+}
+#endif
+
+// --- HARNESS ---
+
+typedef struct
+{
+  const char *name;
+  void (*run)(Vec3 *out);
+  void (*reference)(Vec3 *out); // NULL for the reference kernels themselves
+  float tolerance;              // Largest accepted component error against it
+} Kernel;
+
+Kernel kernels[] = {
+    {"rotateVector", batchRotateVector, NULL, 0.0f},
+    {"  hoisted matrix", batchRotateMatrix, batchRotateVector, 1e-5f},
+    {"calcOutwardNormal", batchCalcOutwardNormal, NULL, 0.0f},
+    {"normalize", batchNormalize, NULL, 0.0f},
+#ifdef __SSE__
+    {"  sse rsqrt", batchNormalizeRsqrt, batchNormalize, 1e-5f},
+#endif
+    {"crossProduct", batchCrossProduct, NULL, 0.0f},
+    {"calcCentroid", batchCalcCentroid, NULL, 0.0f},
+    {"lerp", batchLerp, NULL, 0.0f},
+};
+
+double nowNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Time stamp counter: ticks at a constant reference rate, not core clock
+// cycles, so it does not follow frequency scaling or turbo
+unsigned long long nowTicks()
+{
+#ifdef HAS_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+int compareDouble(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+// Keeps the optimizer from dropping a batch whose output is unused
+void consume(const Vec3 *out)
+{
+  sink += out[0].x + out[BATCH / 2].y + out[BATCH - 1].z;
+}
+
+float maxError(const Vec3 *a, const Vec3 *b)
+{
+  float err = 0.0f;
+  for (int i = 0; i < BATCH; i++)
+  {
+    float d[3] = {fabsf(a[i].x - b[i].x), fabsf(a[i].y - b[i].y), fabsf(a[i].z - b[i].z)};
+    for (int k = 0; k < 3; k++)
+      if (!(d[k] <= err)) // Also catches NaN
+        err = d[k];
+  }
+  return err;
+}
+
+// Returns 0 if a variant disagrees with its reference
+int benchKernel(const Kernel *k)
+{
+  char check[32] = "reference";
+  int ok = 1;
+  if (k->reference)
+  {
+    k->reference(outRef);
+    k->run(outRun);
+    float err = maxError(outRef, outRun);
+    ok = err <= k->tolerance;
+    snprintf(check, sizeof(check), "%s err %.1e", ok ? "ok" : "FAIL", err);
+  }
+
+  // Warm caches, branch predictors and clocks, and size the samples
+  int reps = 0;
+  double start = nowNs();
+  while (nowNs() - start < WARMUP_NS)
+  {
+    k->run(outRun);
+    consume(outRun);
+    reps++;
+  }
+  reps = (int)(reps * MIN_SAMPLE_NS / WARMUP_NS) + 1;
+
+  double ns[SAMPLES], ticks[SAMPLES];
+  for (int s = 0; s < SAMPLES; s++)
+  {
+    double t0 = nowNs();
+    unsigned long long c0 = nowTicks();
+    for (int r = 0; r < reps; r++)
+    {
+      k->run(outRun);
+      consume(outRun);
+    }
+    ticks[s] = (double)(nowTicks() - c0) / ((double)reps * BATCH);
+    ns[s] = (nowNs() - t0) / ((double)reps * BATCH);
+  }
+
+  double mean = 0.0, var = 0.0;
+  for (int s = 0; s < SAMPLES; s++)
+    mean += ns[s];
+  mean /= SAMPLES;
+  for (int s = 0; s < SAMPLES; s++)
+    var += (ns[s] - mean) * (ns[s] - mean);
+  qsort(ns, SAMPLES, sizeof(double), compareDouble);
+  qsort(ticks, SAMPLES, sizeof(double), compareDouble);
+
+  printf("%-20s %8.2f %8.2f %8.2f %8.2f %9.2f   %s\n", k->name, ns[0], ns[SAMPLES / 2], mean,
+         sqrt(var / (SAMPLES - 1)), ticks[SAMPLES / 2], check);
+  return ok;
+}
+
+int main()
+{
+  initInputs();
+  printf("%d elements per batch, %d samples per kernel; times in ns per element\n", BATCH, SAMPLES);
+#ifndef HAS_TSC
+  printf("(no time stamp counter on this target: TSC ticks column is 0)\n");
+#endif
+  printf("%-20s %8s %8s %8s %8s %9s   %s\n", "kernel", "min", "median", "mean", "stddev", "TSC ticks", "check");
+
+  int failed = 0;
+  for (int i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); i++)
+    failed += !benchKernel(&kernels[i]);
+  return failed ? 1 : 0;
+}
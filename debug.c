@@ -3,6 +3,8 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #define M_PI 3.14159265358979323846
 #define FLIP(x) (1 << x)
 
@@ -342,8 +344,239 @@ void drawLightVector()
   glLineWidth(1.0f);
 }
 
+// --- INPUT RECORD / REPLAY ---
+// --record FILE logs every input event with its time since start to a
+// compact binary file. --replay FILE feeds the events back through the
+// same handlers at their original pace, or one event per frame with
+// --max-speed, and writes the time of every frame to FILE.csv. The window
+// size is stored in the header and every resize is an event, so the replay
+// renders the same number of pixels as the session did.
+#define REC_MAGIC "TRRC"
+#define REC_VERSION 2 // 1 had no window size
+
+enum
+{
+  EV_MOUSE,
+  EV_MOTION,
+  EV_SPECIAL,
+  EV_RESHAPE // x, y hold the new width and height
+};
+
+// 12 bytes per event, no padding; written in host byte order
+typedef struct
+{
+  unsigned int timeMs;
+  unsigned char type;
+  unsigned char button; // mouse button, or special key code
+  unsigned char state;
+  unsigned char pad;
+  short x, y;
+} InputEvent;
+
+FILE *recordFile = NULL;
+
+InputEvent *replayEvents = NULL;
+int numReplayEvents = 0;
+int replayNext = 0;
+int replayStartMs = 0;
+int replayMaxSpeed = 0;
+int replayW = 0, replayH = 0; // Window size at the start of the recording
+const char *replayPath = NULL;
+float *frameTimes = NULL;
+int numFrameTimes = 0;
+int frameTimesCapacity = 0;
+
+void mouse(int button, int state, int x, int y);
+void motion(int x, int y);
+void specialKeys(int key, int x, int y);
+void reshape(int w, int h);
+
+void recordEvent(int type, int button, int state, int x, int y)
+{
+  InputEvent ev = {(unsigned int)glutGet(GLUT_ELAPSED_TIME), type, button, state, 0, x, y};
+  fwrite(&ev, sizeof(ev), 1, recordFile);
+}
+
+void recordMouse(int button, int state, int x, int y)
+{
+  recordEvent(EV_MOUSE, button, state, x, y);
+  mouse(button, state, x, y);
+}
+
+void recordMotion(int x, int y)
+{
+  recordEvent(EV_MOTION, 0, 0, x, y);
+  motion(x, y);
+}
+
+void recordSpecial(int key, int x, int y)
+{
+  recordEvent(EV_SPECIAL, key, 0, x, y);
+  specialKeys(key, x, y);
+}
+
+void recordReshape(int w, int h)
+{
+  recordEvent(EV_RESHAPE, 0, 0, w, h);
+  reshape(w, h);
+}
+
+void stopRecording()
+{
+  if (recordFile)
+    fclose(recordFile);
+  recordFile = NULL;
+}
+
+int startRecording(const char *path)
+{
+  recordFile = fopen(path, "wb");
+  if (!recordFile)
+  {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 0;
+  }
+  unsigned int header[3] = {REC_VERSION, (unsigned int)glutGet(GLUT_WINDOW_WIDTH),
+                            (unsigned int)glutGet(GLUT_WINDOW_HEIGHT)};
+  fwrite(REC_MAGIC, 1, 4, recordFile);
+  fwrite(header, sizeof(header), 1, recordFile);
+  atexit(stopRecording);
+  return 1;
+}
+
+int loadReplay(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 0;
+  }
+  char magic[4];
+  unsigned int version = 0;
+  unsigned int size[2] = {0, 0};
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, REC_MAGIC, 4) != 0 ||
+      fread(&version, sizeof(version), 1, f) != 1 || version < 1 || version > REC_VERSION ||
+      (version >= 2 && fread(size, sizeof(size), 1, f) != 1))
+  {
+    fprintf(stderr, "%s is not a recording\n", path);
+    fclose(f);
+    return 0;
+  }
+  replayW = (int)size[0];
+  replayH = (int)size[1];
+
+  long start = ftell(f);
+  fseek(f, 0, SEEK_END);
+  numReplayEvents = (int)((ftell(f) - start) / sizeof(InputEvent));
+  fseek(f, start, SEEK_SET);
+  replayEvents = (InputEvent *)malloc((numReplayEvents + 1) * sizeof(InputEvent));
+  numReplayEvents = (int)fread(replayEvents, sizeof(InputEvent), numReplayEvents, f);
+  fclose(f);
+
+  replayPath = path;
+  printf("replaying %d events from %s%s\n", numReplayEvents, path, replayMaxSpeed ? " at max speed" : "");
+  if (replayW == 0)
+    printf("(version 1 recording: no window size, replaying at the current one)\n");
+  return 1;
+}
+
+void dispatchEvent(const InputEvent *ev)
+{
+  if (ev->type == EV_MOUSE)
+    mouse(ev->button, ev->state, ev->x, ev->y);
+  else if (ev->type == EV_MOTION)
+    motion(ev->x, ev->y);
+  else if (ev->type == EV_SPECIAL)
+    specialKeys(ev->button, ev->x, ev->y);
+  else if (ev->type == EV_RESHAPE)
+    glutReshapeWindow(ev->x, ev->y);
+}
+
+int compareFloat(const void *a, const void *b)
+{
+  float fa = *(const float *)a, fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+void finishReplay()
+{
+  char csvPath[512];
+  snprintf(csvPath, sizeof(csvPath), "%s.csv", replayPath);
+  FILE *f = fopen(csvPath, "w");
+  if (f)
+  {
+    fprintf(f, "frame,ms\n");
+    for (int i = 0; i < numFrameTimes; i++)
+      fprintf(f, "%d,%.3f\n", i, frameTimes[i]);
+    fclose(f);
+  }
+
+  if (numFrameTimes > 0)
+  {
+    float total = 0.0f;
+    for (int i = 0; i < numFrameTimes; i++)
+      total += frameTimes[i];
+    qsort(frameTimes, numFrameTimes, sizeof(float), compareFloat);
+    printf("%d frames in %d ms: mean %.3f ms, median %.3f ms, p95 %.3f ms, max %.3f ms\n",
+           numFrameTimes, glutGet(GLUT_ELAPSED_TIME) - replayStartMs, total / numFrameTimes,
+           frameTimes[numFrameTimes / 2], frameTimes[numFrameTimes * 95 / 100], frameTimes[numFrameTimes - 1]);
+  }
+  printf("frame times written to %s\n", csvPath);
+  exit(0);
+}
+
+// Max speed: one event per frame, driven from idle.
+// A redisplay is forced so each event yields a timed frame.
+void replayIdle()
+{
+  if (replayNext >= numReplayEvents)
+    finishReplay();
+  dispatchEvent(&replayEvents[replayNext++]);
+  glutPostRedisplay();
+}
+
+// Original pace: delivers every event that is due, then sleeps in a GLUT
+// timer until the next one, so the replay does not spin a core between
+// events and skew the profile
+void replayTimer(int value)
+{
+  if (replayNext >= numReplayEvents)
+    finishReplay();
+
+  unsigned int elapsed = glutGet(GLUT_ELAPSED_TIME) - replayStartMs;
+  unsigned int offset = replayEvents[0].timeMs;
+  while (replayNext < numReplayEvents && replayEvents[replayNext].timeMs - offset <= elapsed)
+    dispatchEvent(&replayEvents[replayNext++]);
+  glutPostRedisplay();
+
+  unsigned int wait = 0;
+  elapsed = glutGet(GLUT_ELAPSED_TIME) - replayStartMs;
+  if (replayNext < numReplayEvents && replayEvents[replayNext].timeMs - offset > elapsed)
+    wait = replayEvents[replayNext].timeMs - offset - elapsed;
+  glutTimerFunc(wait, replayTimer, 0);
+}
+
+void recordFrameTime(float ms)
+{
+  if (numFrameTimes == frameTimesCapacity)
+  {
+    frameTimesCapacity = frameTimesCapacity ? frameTimesCapacity * 2 : 1024;
+    frameTimes = (float *)realloc(frameTimes, frameTimesCapacity * sizeof(float));
+  }
+  frameTimes[numFrameTimes++] = ms;
+}
+
+double nowMs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
 void display()
 {
+  double frameStart = nowMs();
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glLoadIdentity();
 
@@ -365,6 +598,12 @@ void display()
   drawRecognizer(1);
 
   glutSwapBuffers();
+
+  if (replayEvents)
+  {
+    glFinish();
+    recordFrameTime((float)(nowMs() - frameStart));
+  }
 }
 
 void mouse(int button, int state, int x, int y)
@@ -396,6 +635,22 @@ void motion(int x, int y)
   }
 }
 
+// Arrow keys step the rotation, for precise repeatable views
+void specialKeys(int key, int x, int y)
+{
+  if (key == GLUT_KEY_LEFT)
+    rotY -= 5.0f;
+  else if (key == GLUT_KEY_RIGHT)
+    rotY += 5.0f;
+  else if (key == GLUT_KEY_UP)
+    rotX -= 5.0f;
+  else if (key == GLUT_KEY_DOWN)
+    rotX += 5.0f;
+  else
+    return;
+  glutPostRedisplay();
+}
+
 void init()
 {
   glClearColor(0.2, 0.2, 0.2, 1.0);
@@ -422,6 +677,18 @@ void reshape(int w, int h)
 
 int main(int argc, char **argv)
 {
+  const char *recordPath = NULL;
+  const char *replayFile = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+      recordPath = argv[++i];
+    else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+      replayFile = argv[++i];
+    else if (strcmp(argv[i], "--max-speed") == 0)
+      replayMaxSpeed = 1;
+  }
+
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
   glutInitWindowSize(800, 600);
@@ -429,8 +696,35 @@ int main(int argc, char **argv)
   init();
   glutDisplayFunc(display);
   glutReshapeFunc(reshape);
-  glutMouseFunc(mouse);
-  glutMotionFunc(motion);
+
+  // Live input is ignored during replay so the session stays identical
+  if (replayFile)
+  {
+    if (!loadReplay(replayFile))
+      return 1;
+    if (replayW > 0 && replayH > 0)
+      glutReshapeWindow(replayW, replayH);
+    replayStartMs = glutGet(GLUT_ELAPSED_TIME);
+    if (replayMaxSpeed)
+      glutIdleFunc(replayIdle);
+    else
+      glutTimerFunc(0, replayTimer, 0);
+  }
+  else if (recordPath)
+  {
+    if (!startRecording(recordPath))
+      return 1;
+    glutMouseFunc(recordMouse);
+    glutMotionFunc(recordMotion);
+    glutSpecialFunc(recordSpecial);
+    glutReshapeFunc(recordReshape);
+  }
+  else
+  {
+    glutMouseFunc(mouse);
+    glutMotionFunc(motion);
+    glutSpecialFunc(specialKeys);
+  }
   glutMainLoop();
   gluDeleteTess(tess);
   return 0;
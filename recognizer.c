@@ -1,7 +1,27 @@
+#define GL_GLEXT_PROTOTYPES // Buffer objects for the frame ring's PBO read-back
 #include <GL/glut.h>
+#ifdef FREEGLUT
+#include <GL/freeglut_ext.h> // glutCloseFunc
+#endif
 #include <GL/glu.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #define FLIP(x) (1 << x)
 
 typedef struct
@@ -9,6 +29,11 @@ typedef struct
   float x, y, z;
 } Vec3;
 
+typedef struct
+{
+  float w, x, y, z;
+} Quat;
+
 // --- MATH CONSTANTS ---
 #define M_PI 3.14159265358979323846
 #define RAD2DEG (180.0f / M_PI)
@@ -37,16 +62,209 @@ Vec3 light = {1.0f, 1.0f, 1.0f};
 // --- GLOBAL STATE ---
 int currentFrame = 0;
 int isWireframe = 0;
+float wireWidth = 2.0f;
+int emissivePass = 0;       // Set while drawing the glow layer: wires only, solids black
+float glowWireWidth = 1.0f; // Line width in that (smaller) layer
 float curX, curY, curZ;
 float curPitch, curYaw, curRoll;
+Quat curRot; // Orientation actually drawn (may be slerped between samples)
 
 // Colors
 float colorWire[] = {1.0f, 0.0f, 0.0f};
 float colorSolid[] = {0.133f, 0.275f, 0.024f}; // #224606
+float colorBlack[] = {0.0f, 0.0f, 0.0f};
 
 // --- TESSELATOR OBJECT ---
 GLUtesselator *tess;
 
+// --- TRACING ---
+// Optional timeline of what a frame costs. Stages are recorded as begin/end
+// pairs, GL calls on the per-frame path go through GLT() so they are counted
+// and timed (CPU submission time, not GPU time), and per-frame totals are
+// emitted as counters. The result is Chrome trace-event JSON, viewable in
+// chrome://tracing or Perfetto. Start with --trace or toggle with 't'.
+// drawPolyPart only runs during the bake, so it appears as scopes there;
+// per frame the baked mesh is counted as mesh draws instead.
+typedef struct
+{
+  char ph;          // 'B', 'E', 'X' or 'C'
+  const char *name; // For GLT() events this is the call text
+  double ts, dur;   // Microseconds
+  int args[5];
+} TraceEvent;
+
+// What a GL call does, for the per-frame counters
+enum
+{
+  GL_KIND_STATE,       // Changes state read by later draws
+  GL_KIND_DRAW,        // Emits primitives
+  GL_KIND_FRAMEBUFFER, // Clears, accumulates or copies pixels
+  GL_KIND_VERTEX,      // Feeds vertices inside glBegin/glEnd
+  NUM_GL_KINDS
+};
+
+TraceEvent *traceEvents = NULL;
+int numTraceEvents = 0;
+int traceCapacity = 0;
+int traceEnabled = 0;
+double traceOrigin = 0.0;
+int traceFrames = 0;
+int frameGLCalls = 0;
+int frameKindCalls[NUM_GL_KINDS];
+int frameMeshDraws = 0;
+const char *traceFile = "recognizer_trace.json";
+
+double traceNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+TraceEvent *traceEvent(char ph, const char *name)
+{
+  if (numTraceEvents >= traceCapacity)
+  {
+    traceCapacity = traceCapacity ? traceCapacity * 2 : 4096;
+    traceEvents = (TraceEvent *)realloc(traceEvents, traceCapacity * sizeof(TraceEvent));
+  }
+  TraceEvent *e = &traceEvents[numTraceEvents++];
+  e->ph = ph;
+  e->name = name;
+  e->ts = traceNow() - traceOrigin;
+  e->dur = 0.0;
+  return e;
+}
+
+void traceBegin(const char *name)
+{
+  if (traceEnabled)
+    traceEvent('B', name);
+}
+
+void traceEnd(const char *name)
+{
+  if (traceEnabled)
+    traceEvent('E', name);
+}
+
+int glCallKind(const char *call)
+{
+  static const struct
+  {
+    const char *prefix;
+    int kind;
+  } kinds[] = {
+      {"glDraw", GL_KIND_DRAW},
+      {"glCallList", GL_KIND_DRAW},
+      {"glBeginQuery", GL_KIND_STATE},
+      {"glBegin", GL_KIND_DRAW},
+      {"glutBitmap", GL_KIND_DRAW},
+      {"glClear", GL_KIND_FRAMEBUFFER},
+      {"glAccum", GL_KIND_FRAMEBUFFER},
+      {"glCopyTex", GL_KIND_FRAMEBUFFER},
+      {"glReadPixels", GL_KIND_FRAMEBUFFER},
+      {"glVertex", GL_KIND_VERTEX},
+      {"glTexCoord", GL_KIND_VERTEX},
+      {"glEnd(", GL_KIND_VERTEX},
+  };
+  for (int i = 0; i < (int)(sizeof(kinds) / sizeof(kinds[0])); i++)
+    if (strncmp(call, kinds[i].prefix, strlen(kinds[i].prefix)) == 0)
+      return kinds[i].kind;
+  return GL_KIND_STATE;
+}
+
+void traceGLCall(const char *call, double start)
+{
+  double end = traceNow();
+  TraceEvent *e = traceEvent('X', call);
+  e->ts = start - traceOrigin;
+  e->dur = end - start;
+  frameGLCalls++;
+  frameKindCalls[glCallKind(call)]++;
+}
+
+void traceResetFrame()
+{
+  frameGLCalls = 0;
+  memset(frameKindCalls, 0, sizeof(frameKindCalls));
+  frameMeshDraws = 0;
+}
+
+// Closes a frame: one counter sample, then the per-frame tallies restart
+void traceFrameEnd()
+{
+  if (!traceEnabled)
+    return;
+  TraceEvent *e = traceEvent('C', "per frame");
+  e->args[0] = frameGLCalls;
+  e->args[1] = frameKindCalls[GL_KIND_STATE];
+  e->args[2] = frameKindCalls[GL_KIND_DRAW];
+  e->args[3] = frameKindCalls[GL_KIND_FRAMEBUFFER];
+  e->args[4] = frameMeshDraws;
+  traceResetFrame();
+  traceFrames++;
+}
+
+void writeTrace(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+  {
+    printf("Cannot write %s\n", path);
+    return;
+  }
+  fprintf(f, "{\"traceEvents\":[\n");
+  for (int i = 0; i < numTraceEvents; i++)
+  {
+    TraceEvent *e = &traceEvents[i];
+    // GLT() events carry the whole call; the function name is enough here
+    int len = (int)strcspn(e->name, "(");
+    fprintf(f, "{\"name\":\"%.*s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1", len, e->name, e->ph, e->ts);
+    if (e->ph == 'X')
+      fprintf(f, ",\"cat\":\"gl\",\"dur\":%.3f", e->dur);
+    else if (e->ph == 'C')
+      fprintf(f, ",\"args\":{\"gl calls\":%d,\"state changes\":%d,\"draw calls\":%d,\"framebuffer ops\":%d,\"mesh draws\":%d}",
+              e->args[0], e->args[1], e->args[2], e->args[3], e->args[4]);
+    fprintf(f, "}%s\n", i + 1 < numTraceEvents ? "," : "");
+  }
+  fprintf(f, "]}\n");
+  fclose(f);
+}
+
+void startTrace()
+{
+  numTraceEvents = 0;
+  traceFrames = 0;
+  traceResetFrame();
+  traceOrigin = traceNow();
+  traceEnabled = 1;
+}
+
+void stopTrace()
+{
+  if (!traceEnabled)
+    return;
+  traceEnabled = 0;
+  writeTrace(traceFile);
+  printf("Trace: %d frames, %d events -> %s\n", traceFrames, numTraceEvents, traceFile);
+}
+
+#define GLT(call)                  \
+  do                               \
+  {                                \
+    if (traceEnabled)              \
+    {                              \
+      double glStart_ = traceNow(); \
+      call;                        \
+      traceGLCall(#call, glStart_); \
+    }                              \
+    else                           \
+    {                              \
+      call;                        \
+    }                              \
+  } while (0)
+
 // --- MATH HELPERS ---
 
 float lerp(float start, float end, float t)
@@ -113,29 +331,269 @@ Vec3 rotateVector(Vec3 v, float pitch, float yaw, float roll)
   return res;
 }
 
-// --- COLOR LOGIC ---
-void setFaceColor(Vec3 normal)
+// --- QUATERNIONS ---
+
+Quat quatMul(Quat a, Quat b)
 {
-  if (isWireframe)
+  Quat r;
+  r.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+  r.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+  r.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+  r.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+  return r;
+}
+
+Quat quatAxisAngle(float ax, float ay, float az, float angle)
+{
+  float s = sin(angle / 2.0f);
+  Quat q = {cos(angle / 2.0f), ax * s, ay * s, az * s};
+  return q;
+}
+
+// Same order as rotateVector / display(): pitch first, then yaw, then roll
+Quat eulerToQuat(float pitch, float yaw, float roll)
+{
+  Quat qx = quatAxisAngle(1.0f, 0.0f, 0.0f, pitch);
+  Quat qy = quatAxisAngle(0.0f, 1.0f, 0.0f, yaw);
+  Quat qz = quatAxisAngle(0.0f, 0.0f, 1.0f, roll);
+  return quatMul(qz, quatMul(qy, qx));
+}
+
+Quat quatSlerp(Quat a, Quat b, float t)
+{
+  float d = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+  // Take the short way around
+  if (d < 0.0f)
   {
-    glColor3fv(colorWire);
-    return;
+    b.w = -b.w;
+    b.x = -b.x;
+    b.y = -b.y;
+    b.z = -b.z;
+    d = -d;
+  }
+  float wa, wb;
+  if (d > 0.9995f)
+  {
+    // Nearly parallel: plain lerp, renormalized below
+    wa = 1.0f - t;
+    wb = t;
   }
-  Vec3 rotNorm = rotateVector(normal, curPitch, curYaw, curRoll);
-  float dot = dotProduct(rotNorm, light);
-  if (dot > 0.2f)
-    glColor3fv(colorSolid);
   else
-    glColor3f(0.0f, 0.0f, 0.0f);
+  {
+    float theta = acos(d);
+    float st = sin(theta);
+    wa = sin((1.0f - t) * theta) / st;
+    wb = sin(t * theta) / st;
+  }
+  Quat r = {wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z};
+  float len = sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+  r.w /= len;
+  r.x /= len;
+  r.y /= len;
+  r.z /= len;
+  return r;
+}
+
+Vec3 quatRotate(Quat q, Vec3 v)
+{
+  // v' = v + 2w(u x v) + 2u x (u x v)
+  Vec3 u = {q.x, q.y, q.z};
+  Vec3 t = crossProduct(u, v);
+  t.x *= 2.0f;
+  t.y *= 2.0f;
+  t.z *= 2.0f;
+  Vec3 c = crossProduct(u, t);
+  Vec3 res = {v.x + q.w * t.x + c.x, v.y + q.w * t.y + c.y, v.z + q.w * t.z + c.z};
+  return res;
+}
+
+// Column-major, ready for glMultMatrixf
+void quatToMatrix(Quat q, float m[16])
+{
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  m[0] = 1.0f - 2.0f * (yy + zz);
+  m[1] = 2.0f * (xy + wz);
+  m[2] = 2.0f * (xz - wy);
+  m[3] = 0.0f;
+  m[4] = 2.0f * (xy - wz);
+  m[5] = 1.0f - 2.0f * (xx + zz);
+  m[6] = 2.0f * (yz + wx);
+  m[7] = 0.0f;
+  m[8] = 2.0f * (xz + wy);
+  m[9] = 2.0f * (yz - wx);
+  m[10] = 1.0f - 2.0f * (xx + yy);
+  m[11] = 0.0f;
+  m[12] = 0.0f;
+  m[13] = 0.0f;
+  m[14] = 0.0f;
+  m[15] = 1.0f;
+}
+
+// --- BAKED MESH ---
+// The model never changes shape, so drawRecognizer() only runs once in init().
+// Every primitive it emits is captured here as plain triangles (solid pass) and
+// line segments (wire pass). Per frame we just recolor the solid faces
+// (shadeMesh) and replay both arrays with one glDrawArrays each (drawModel).
+#define MAX_MESH_VERTS 4096
+#define MAX_MESH_FACES 256
+#define MAX_PRIM_VERTS 256
+
+typedef struct
+{
+  Vec3 normal;
+  int first, count; // Range of this face in triVerts
+} Face;
+
+float triVerts[MAX_MESH_VERTS][3];
+float triColors[MAX_MESH_VERTS][3];
+float lineVerts[MAX_MESH_VERTS][3];
+Face faces[MAX_MESH_FACES];
+int numTriVerts = 0;
+int numLineVerts = 0;
+int numFaces = 0;
+
+// Primitive being assembled between bakeBegin() and bakeEnd()
+GLenum bakeMode;
+float bakeBuf[MAX_PRIM_VERTS][3];
+int bakeCount = 0;
+
+void pushVertex(float dst[][3], int *count, const float *v)
+{
+  if (*count >= MAX_MESH_VERTS)
+    return;
+  dst[*count][0] = v[0];
+  dst[*count][1] = v[1];
+  dst[*count][2] = v[2];
+  (*count)++;
+}
+
+// Starts a new solid face; everything baked until the next call shares its normal
+void beginFace(Vec3 normal)
+{
+  if (isWireframe || numFaces >= MAX_MESH_FACES)
+    return;
+  faces[numFaces].normal = normal;
+  faces[numFaces].first = numTriVerts;
+  faces[numFaces].count = 0;
+  numFaces++;
+}
+
+void bakeBegin(GLenum mode)
+{
+  bakeMode = mode;
+  bakeCount = 0;
+}
+
+void bakeVertex(float x, float y, float z)
+{
+  if (bakeCount >= MAX_PRIM_VERTS)
+    return;
+  bakeBuf[bakeCount][0] = x;
+  bakeBuf[bakeCount][1] = y;
+  bakeBuf[bakeCount][2] = z;
+  bakeCount++;
+}
+
+void bakeEnd()
+{
+  if (bakeMode == GL_LINE_LOOP)
+  {
+    for (int i = 0; i < bakeCount; i++)
+    {
+      pushVertex(lineVerts, &numLineVerts, bakeBuf[i]);
+      pushVertex(lineVerts, &numLineVerts, bakeBuf[(i + 1) % bakeCount]);
+    }
+  }
+  else if (bakeMode == GL_QUADS)
+  {
+    for (int i = 0; i + 3 < bakeCount; i += 4)
+    {
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 1]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 2]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 2]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 3]);
+    }
+  }
+  else // GL_TRIANGLES (the edge flag callback keeps the tessellator from emitting fans/strips)
+  {
+    for (int i = 0; i + 2 < bakeCount; i += 3)
+    {
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 1]);
+      pushVertex(triVerts, &numTriVerts, bakeBuf[i + 2]);
+    }
+  }
+
+  if (!isWireframe && numFaces > 0)
+    faces[numFaces - 1].count = numTriVerts - faces[numFaces - 1].first;
+  bakeCount = 0;
+}
+
+// The geometry that never changes color is compiled into display lists once
+// baked, so it stays on the GL side: the wire pass, and the bare solid
+// triangles used by the glow layer and the shadow (color set by the caller).
+// The shaded solid pass is recolored every frame and stays a client array.
+GLuint meshWireList = 0;
+GLuint meshSolidList = 0;
+
+void buildMeshLists()
+{
+  meshWireList = glGenLists(2);
+  meshSolidList = meshWireList + 1;
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, lineVerts);
+  glNewList(meshWireList, GL_COMPILE);
+  glDrawArrays(GL_LINES, 0, numLineVerts);
+  glEndList();
+  glVertexPointer(3, GL_FLOAT, 0, triVerts);
+  glNewList(meshSolidList, GL_COMPILE);
+  glDrawArrays(GL_TRIANGLES, 0, numTriVerts);
+  glEndList();
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// --- COLOR LOGIC ---
+// Same binary threshold as before, evaluated once per face. Rotating the light
+// into model space once is the same test as rotating every normal out of it.
+// Writes one color per baked triangle vertex into colors.
+void shadeMeshLocal(Vec3 localLight, float (*colors)[3])
+{
+  for (int f = 0; f < numFaces; f++)
+  {
+    float dot = dotProduct(faces[f].normal, localLight);
+    const float *c = (dot > 0.2f) ? colorSolid : colorBlack;
+    for (int i = faces[f].first; i < faces[f].first + faces[f].count; i++)
+    {
+      colors[i][0] = c[0];
+      colors[i][1] = c[1];
+      colors[i][2] = c[2];
+    }
+  }
+}
+
+// Shades for the current pose
+void shadeMesh()
+{
+  Quat inv = {curRot.w, -curRot.x, -curRot.y, -curRot.z};
+  shadeMeshLocal(quatRotate(inv, light), triColors);
 }
 
 // --- TESSELATOR CALLBACKS ---
 #ifndef CALLBACK
 #define CALLBACK
 #endif
-void CALLBACK tessBeginCB(GLenum which) { glBegin(which); }
-void CALLBACK tessEndCB() { glEnd(); }
-void CALLBACK tessVertexCB(const GLvoid *data) { glVertex3dv((const GLdouble *)data); }
+void CALLBACK tessBeginCB(GLenum which) { bakeBegin(which); }
+void CALLBACK tessEndCB() { bakeEnd(); }
+void CALLBACK tessVertexCB(const GLvoid *data)
+{
+  const GLdouble *v = (const GLdouble *)data;
+  bakeVertex(v[0], v[1], v[2]);
+}
+void CALLBACK tessEdgeFlagCB(GLboolean flag) {}
 void CALLBACK tessCombineCB(GLdouble coords[3], GLdouble *vertex_data[4], GLfloat weight[4], GLdouble **outData)
 {
   GLdouble *vertex = (GLdouble *)malloc(3 * sizeof(GLdouble));
@@ -191,6 +649,7 @@ Vec3 calcOutwardNormal(Vec3 p1, Vec3 p2, Vec3 p3, Vec3 centroid, Vec3 faceCenter
 
 void drawPolyPart(float data[][4], int n, int flipMask)
 {
+  traceBegin("drawPolyPart");
 
   // 1. Calculate Centroid of this specific part
   Vec3 centroid = calcCentroid(data, n);
@@ -214,15 +673,15 @@ void drawPolyPart(float data[][4], int n, int flipMask)
     faceCenter.y /= n;
     faceCenter.z /= n;
 
-    setFaceColor(calcOutwardNormal(p0, p1, p2, centroid, faceCenter));
+    beginFace(calcOutwardNormal(p0, p1, p2, centroid, faceCenter));
   }
 
   if (isWireframe)
   {
-    glBegin(GL_LINE_LOOP);
+    bakeBegin(GL_LINE_LOOP);
     for (int i = 0; i < n; i++)
-      glVertex3f(data[i][0], data[i][1], data[i][2]);
-    glEnd();
+      bakeVertex(data[i][0], data[i][1], data[i][2]);
+    bakeEnd();
   }
   else
   {
@@ -259,15 +718,15 @@ void drawPolyPart(float data[][4], int n, int flipMask)
     faceCenter.y /= n;
     faceCenter.z /= n;
 
-    setFaceColor(calcOutwardNormal(p0, p1, p2, centroid, faceCenter));
+    beginFace(calcOutwardNormal(p0, p1, p2, centroid, faceCenter));
   }
 
   if (isWireframe)
   {
-    glBegin(GL_LINE_LOOP);
+    bakeBegin(GL_LINE_LOOP);
     for (int i = n - 1; i >= 0; i--)
-      glVertex3f(data[i][0], data[i][1], data[i][3]);
-    glEnd();
+      bakeVertex(data[i][0], data[i][1], data[i][3]);
+    bakeEnd();
   }
   else
   {
@@ -310,15 +769,16 @@ void drawPolyPart(float data[][4], int n, int flipMask)
       n.y = -n.y;
       n.z = -n.z;
     }
-    setFaceColor(n);
+    beginFace(n);
 
-    glBegin(isWireframe ? GL_LINE_LOOP : GL_QUADS);
-    glVertex3f(p1.x, p1.y, p1.z);
-    glVertex3f(p2.x, p2.y, p2.z);
-    glVertex3f(p3.x, p3.y, p3.z);
-    glVertex3f(p4.x, p4.y, p4.z);
-    glEnd();
+    bakeBegin(isWireframe ? GL_LINE_LOOP : GL_QUADS);
+    bakeVertex(p1.x, p1.y, p1.z);
+    bakeVertex(p2.x, p2.y, p2.z);
+    bakeVertex(p3.x, p3.y, p3.z);
+    bakeVertex(p4.x, p4.y, p4.z);
+    bakeEnd();
   }
+  traceEnd("drawPolyPart");
 }
 
 // --- DATA IMPORT ---
@@ -369,9 +829,14 @@ void drawRecognizer()
 }
 
 // --- MAIN LOOP ---
-void calculatePath(int frame)
+// Analytic path; frame is continuous time in 24 fps units and the pose holds at both ends
+void calculatePath(float frame)
 {
-  float t = (float)frame / (float)(MAX_FRAMES - 1);
+  float t = frame / (float)(MAX_FRAMES - 1);
+  if (t < 0.0f)
+    t = 0.0f;
+  if (t > 1.0f)
+    t = 1.0f;
   float theta = lerp(M_PI, 0.0f, t);
   curX = radius * cos(theta);
   curZ = radius * sin(-theta);
@@ -379,139 +844,2284 @@ void calculatePath(int frame)
   curPitch = lerp(startPitch, endPitch, t);
   curYaw = lerp(startYaw, endYaw, t);
   curRoll = lerp(startRoll, endRoll, t);
+  curRot = eulerToQuat(curPitch, curYaw, curRoll);
 }
 
-void renderFrameCounter()
+// Pose between the two surrounding 24 fps samples: position lerped,
+// orientation slerped. This is what gets drawn at display refresh rate.
+void setPose(float frame)
 {
-  glMatrixMode(GL_PROJECTION);
-  glPushMatrix();
-  glLoadIdentity();
-  gluOrtho2D(0, 800, 0, 600);
-  glMatrixMode(GL_MODELVIEW);
-  glPushMatrix();
-  glLoadIdentity();
-  glColor3f(1.0f, 1.0f, 1.0f);
-  glRasterPos2i(20, 570);
-  char buffer[20];
-  sprintf(buffer, "%03d", currentFrame);
-  for (char *c = buffer; *c != '\0'; c++)
-    glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *c);
-  glMatrixMode(GL_MODELVIEW);
-  glPopMatrix();
-  glMatrixMode(GL_PROJECTION);
-  glPopMatrix();
-  glMatrixMode(GL_MODELVIEW);
+  float k0 = floor(frame);
+  float a = frame - k0;
+  calculatePath(k0);
+  float x0 = curX, y0 = curY, z0 = curZ;
+  Quat q0 = curRot;
+  calculatePath(k0 + 1.0f);
+  curX = lerp(x0, curX, a);
+  curY = lerp(y0, curY, a);
+  curZ = lerp(z0, curZ, a);
+  curRot = quatSlerp(q0, curRot, a);
 }
 
-void drawLightVector()
+// --- PLAYBACK ---
+// Playback runs off the wall clock and redraws as fast as the display swaps,
+// so 24 fps animation is shown at whatever the monitor refreshes at.
+// latchCadence snaps back to whole 24 fps frames for reference viewing.
+int isPlaying = 0;
+int latchCadence = 0;
+float animFrame = 0.0f; // Continuous playhead, in frames
+int playStartMs = 0;
+float playStartFrame = 0.0f;
+
+void idle()
 {
-  glDisable(GL_LIGHTING);
-  glDisable(GL_DEPTH_TEST);
-  glLineWidth(3.0f);
+  float elapsed = (glutGet(GLUT_ELAPSED_TIME) - playStartMs) / 1000.0f;
+  animFrame = playStartFrame + elapsed * FPS;
+  if (animFrame >= MAX_FRAMES - 1)
+  {
+    animFrame = MAX_FRAMES - 1;
+    isPlaying = 0;
+    glutIdleFunc(NULL);
+  }
+  if (latchCadence)
+    animFrame = floor(animFrame);
+  currentFrame = (int)animFrame;
+  glutPostRedisplay();
+}
 
-  float scale = 8.0f;
+void setPlaying(int play)
+{
+  isPlaying = play;
+  if (isPlaying)
+  {
+    if (animFrame >= MAX_FRAMES - 1)
+      animFrame = 0.0f;
+    playStartMs = glutGet(GLUT_ELAPSED_TIME);
+    playStartFrame = animFrame;
+  }
+  glutIdleFunc(isPlaying ? idle : NULL);
+}
 
-  glBegin(GL_LINES);
-  glColor3f(0.0f, 0.5f, 1.0f);
-  glVertex3f(0.0f, 0.0f, 0.0f);
-  glVertex3f(light.x * scale, light.y * scale, light.z * scale);
-  glEnd();
+// --- CROWD SIMULATION ---
+// Path evaluation for large numbers of crafts. Per-craft path parameters and
+// outputs are kept as structure-of-arrays so the kernel can evaluate four
+// crafts per SSE register; the work is split into chunks that a small
+// pthread pool (plus the calling thread) pulls from a shared counter. Each
+// craft's model matrix is written straight into crowd.transforms, laid out
+// for glMultMatrixf. The path is calculatePath()'s, with each craft's own
+// arc center, radius, heights and time offset/scale.
+#define CROWD_MAX_THREADS 16
+#define CROWD_CHUNK 4096 // Crafts per work item, a multiple of 4
 
-  glEnable(GL_DEPTH_TEST);
-  glLineWidth(1.0f);
+typedef struct
+{
+  int count;
+  // Path parameters
+  float *centerX, *centerZ, *radius;
+  float *startY, *endY;
+  float *timeOffset, *timeScale; // Craft frame = frame * timeScale + timeOffset
+  // Outputs
+  float *x, *y, *z;
+  float *pitch, *yaw, *roll;
+  float (*transforms)[16];
+} Crowd;
+
+Crowd crowd = {0};
+int crowdMode = 0;
+int crowdSize = 100000;
+int crowdDrawLimit = 256; // Crafts actually drawn; all of them are simulated
+float crowdSimMs = 0.0f;
+float (*crowdColors)[3] = NULL; // Drawn crafts' vertex colors, numTriVerts each
+int crowdShaded = 0;            // crowdColors is up to date with the transforms
+
+pthread_t crowdThreads[CROWD_MAX_THREADS];
+int numCrowdThreads = 0;
+pthread_mutex_t crowdLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t crowdWake = PTHREAD_COND_INITIALIZER;
+pthread_cond_t crowdDone = PTHREAD_COND_INITIALIZER;
+int crowdGeneration = 0;
+int crowdWorking = 0; // Workers still inside the current generation
+int crowdNextChunk = 0;
+float crowdFrame = 0.0f;
+
+float *crowdAlloc(int n)
+{
+  // 16-byte aligned, padded to a whole SSE batch
+  return (float *)aligned_alloc(16, ((n + 3) & ~3) * sizeof(float));
 }
 
+// Returns 0, with nothing allocated, if memory runs out
+int crowdInit(int count)
+{
+  float **arrays[] = {&crowd.centerX, &crowd.centerZ, &crowd.radius, &crowd.startY, &crowd.endY,
+                      &crowd.timeOffset, &crowd.timeScale, &crowd.x, &crowd.y, &crowd.z,
+                      &crowd.pitch, &crowd.yaw, &crowd.roll};
+  int numArrays = (int)(sizeof(arrays) / sizeof(arrays[0]));
+  int ok = 1;
+  for (int a = 0; a < numArrays; a++)
+  {
+    *arrays[a] = crowdAlloc(count);
+    ok = ok && *arrays[a];
+  }
+  crowd.transforms = (float(*)[16])aligned_alloc(16, ((count + 3) & ~3) * sizeof(float[16]));
+  if (!ok || !crowd.transforms)
+  {
+    for (int a = 0; a < numArrays; a++)
+    {
+      free(*arrays[a]);
+      *arrays[a] = NULL;
+    }
+    free(crowd.transforms);
+    crowd.transforms = NULL;
+    printf("Crowd: out of memory for %d crafts\n", count);
+    return 0;
+  }
+  crowd.count = count;
 
-void display()
+  // Sunflower spiral around the hero, so the first (drawn) crafts are the
+  // nearest ones; each gets its own arc, start height and timing
+  srand(1982);
+  for (int i = 0; i < ((count + 3) & ~3); i++)
+  {
+    float dist = 8.0f * sqrt(i + 2.0f);
+    float angle = i * 2.39996f; // Golden angle
+    crowd.centerX[i] = dist * cos(angle);
+    crowd.centerZ[i] = dist * sin(angle);
+    crowd.radius[i] = radius * (0.5f + rand() / (float)RAND_MAX);
+    crowd.startY[i] = startY + 4.0f * rand() / (float)RAND_MAX;
+    crowd.endY[i] = endY;
+    crowd.timeOffset[i] = -(float)(rand() % MAX_FRAMES);
+    crowd.timeScale[i] = 0.75f + 0.5f * rand() / (float)RAND_MAX;
+  }
+  return 1;
+}
+
+#ifdef __SSE2__
+// sin and cos together for |x| up to a few turns: reduce to [-pi, pi], fold
+// into [-pi/2, pi/2] (cos changes sign when folded), then Taylor polynomials
+// of degree 11/12, accurate to about 1e-6 on that range
+void sinCosPS(__m128 x, __m128 *sinOut, __m128 *cosOut)
 {
-  calculatePath(currentFrame);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glLoadIdentity();
-  gluLookAt(0.0, 5.0, 15.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+  const __m128 twoPi = _mm_set1_ps(2.0f * M_PI), invTwoPi = _mm_set1_ps(1.0f / (2.0f * M_PI));
+  const __m128 pi = _mm_set1_ps(M_PI), halfPi = _mm_set1_ps(M_PI / 2.0f);
+  const __m128 negZero = _mm_set1_ps(-0.0f);
+  __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, invTwoPi)));
+  x = _mm_sub_ps(x, _mm_mul_ps(k, twoPi));
+  __m128 hi = _mm_cmpgt_ps(x, halfPi);
+  __m128 lo = _mm_cmplt_ps(x, _mm_xor_ps(halfPi, negZero));
+  // pi - x above, -pi - x below
+  __m128 mirror = _mm_sub_ps(_mm_or_ps(_mm_and_ps(hi, pi), _mm_and_ps(lo, _mm_xor_ps(pi, negZero))), x);
+  __m128 folded = _mm_or_ps(hi, lo);
+  x = _mm_or_ps(_mm_and_ps(folded, mirror), _mm_andnot_ps(folded, x));
+  __m128 cosSign = _mm_and_ps(folded, negZero);
 
-  drawLightVector();
+  __m128 x2 = _mm_mul_ps(x, x);
+  __m128 sp = _mm_set1_ps(-1.0f / 39916800.0f);
+  sp = _mm_add_ps(_mm_mul_ps(sp, x2), _mm_set1_ps(1.0f / 362880.0f));
+  sp = _mm_add_ps(_mm_mul_ps(sp, x2), _mm_set1_ps(-1.0f / 5040.0f));
+  sp = _mm_add_ps(_mm_mul_ps(sp, x2), _mm_set1_ps(1.0f / 120.0f));
+  sp = _mm_add_ps(_mm_mul_ps(sp, x2), _mm_set1_ps(-1.0f / 6.0f));
+  sp = _mm_add_ps(_mm_mul_ps(sp, x2), _mm_set1_ps(1.0f));
+  *sinOut = _mm_mul_ps(sp, x);
+
+  __m128 cp = _mm_set1_ps(1.0f / 479001600.0f);
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(-1.0f / 3628800.0f));
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(1.0f / 40320.0f));
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(-1.0f / 720.0f));
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(1.0f / 24.0f));
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(-1.0f / 2.0f));
+  cp = _mm_add_ps(_mm_mul_ps(cp, x2), _mm_set1_ps(1.0f));
+  *cosOut = _mm_xor_ps(cp, cosSign);
+}
+
+__m128 lerpPS(float start, float end, __m128 t)
+{
+  return _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(t, _mm_set1_ps(end - start)));
+}
+#endif
+
+// Writes craft i's model matrix, same convention as applyModelTransform()
+void crowdStoreTransform(int i, float cp, float sp, float cy, float sy, float cr, float sr)
+{
+  float *m = crowd.transforms[i];
+  m[0] = cr * cy;
+  m[1] = sr * cy;
+  m[2] = -sy;
+  m[3] = 0.0f;
+  m[4] = cr * sy * sp - sr * cp;
+  m[5] = sr * sy * sp + cr * cp;
+  m[6] = cy * sp;
+  m[7] = 0.0f;
+  m[8] = cr * sy * cp + sr * sp;
+  m[9] = sr * sy * cp - cr * sp;
+  m[10] = cy * cp;
+  m[11] = 0.0f;
+  m[12] = crowd.x[i];
+  m[13] = crowd.y[i];
+  m[14] = crowd.z[i];
+  m[15] = 1.0f;
+}
+
+// Scalar reference, also used for the tail when SSE2 is not available
+void crowdEvalScalar(int i, float frame)
+{
+  float t = (frame * crowd.timeScale[i] + crowd.timeOffset[i]) / (float)(MAX_FRAMES - 1);
+  t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+  float theta = lerp(M_PI, 0.0f, t);
+  crowd.x[i] = crowd.centerX[i] + crowd.radius[i] * cos(theta);
+  crowd.z[i] = crowd.centerZ[i] + crowd.radius[i] * sin(-theta);
+  crowd.y[i] = lerp(crowd.startY[i], crowd.endY[i], t);
+  crowd.pitch[i] = lerp(startPitch, endPitch, t);
+  crowd.yaw[i] = lerp(startYaw, endYaw, t);
+  crowd.roll[i] = lerp(startRoll, endRoll, t);
+  crowdStoreTransform(i, cos(crowd.pitch[i]), sin(crowd.pitch[i]), cos(crowd.yaw[i]), sin(crowd.yaw[i]),
+                      cos(crowd.roll[i]), sin(crowd.roll[i]));
+}
 
-  if (!isWireframe)
+void crowdEvalRange(int first, int last, float frame)
+{
+  int i = first;
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+  const __m128 vFrame = _mm_set1_ps(frame), invSpan = _mm_set1_ps(1.0f / (MAX_FRAMES - 1));
+  for (; i + 4 <= last; i += 4)
   {
-    glBegin(GL_LINES);
-    glColor3f(0.15f, 0.15f, 0.15f);
-    for (float i = -10; i <= 10; i += 1.0f)
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vFrame, _mm_load_ps(crowd.timeScale + i)), _mm_load_ps(crowd.timeOffset + i)), invSpan);
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+    __m128 theta = lerpPS(M_PI, 0.0f, t);
+    __m128 r = _mm_load_ps(crowd.radius + i);
+    __m128 sy0 = _mm_load_ps(crowd.startY + i);
+    __m128 st, ct;
+    sinCosPS(theta, &st, &ct);
+    __m128 x = _mm_add_ps(_mm_load_ps(crowd.centerX + i), _mm_mul_ps(r, ct));
+    __m128 z = _mm_sub_ps(_mm_load_ps(crowd.centerZ + i), _mm_mul_ps(r, st));
+    __m128 y = _mm_add_ps(sy0, _mm_mul_ps(t, _mm_sub_ps(_mm_load_ps(crowd.endY + i), sy0)));
+    __m128 pitch = lerpPS(startPitch, endPitch, t);
+    __m128 yaw = lerpPS(startYaw, endYaw, t);
+    __m128 roll = lerpPS(startRoll, endRoll, t);
+    _mm_store_ps(crowd.x + i, x);
+    _mm_store_ps(crowd.y + i, y);
+    _mm_store_ps(crowd.z + i, z);
+    _mm_store_ps(crowd.pitch + i, pitch);
+    _mm_store_ps(crowd.yaw + i, yaw);
+    _mm_store_ps(crowd.roll + i, roll);
+
+    // Same terms as crowdStoreTransform, four crafts at a time; each group of
+    // four matrix entries is transposed so every craft gets one aligned store
+    __m128 cp, sp, cy, sy, cr, sr;
+    sinCosPS(pitch, &sp, &cp);
+    sinCosPS(yaw, &sy, &cy);
+    sinCosPS(roll, &sr, &cr);
+    __m128 sysp = _mm_mul_ps(sy, sp), sycp = _mm_mul_ps(sy, cp);
+    __m128 col[4][4] = {
+        {_mm_mul_ps(cr, cy), _mm_mul_ps(sr, cy), _mm_sub_ps(zero, sy), zero},
+        {_mm_sub_ps(_mm_mul_ps(cr, sysp), _mm_mul_ps(sr, cp)), _mm_add_ps(_mm_mul_ps(sr, sysp), _mm_mul_ps(cr, cp)), _mm_mul_ps(cy, sp), zero},
+        {_mm_add_ps(_mm_mul_ps(cr, sycp), _mm_mul_ps(sr, sp)), _mm_sub_ps(_mm_mul_ps(sr, sycp), _mm_mul_ps(cr, sp)), _mm_mul_ps(cy, cp), zero},
+        {x, y, z, one},
+    };
+    for (int c = 0; c < 4; c++)
     {
-      glVertex3f(i, -3, 10);
-      glVertex3f(i, -3, -10);
-      glVertex3f(10, -3, i);
-      glVertex3f(-10, -3, i);
+      _MM_TRANSPOSE4_PS(col[c][0], col[c][1], col[c][2], col[c][3]);
+      for (int k = 0; k < 4; k++)
+        _mm_store_ps(crowd.transforms[i + k] + c * 4, col[c][k]);
     }
-    glEnd();
   }
+#endif
+  for (; i < last; i++)
+    crowdEvalScalar(i, frame);
+}
 
-  glPushMatrix();
-  glTranslatef(curX, curY, curZ);
-  glRotatef(curRoll * RAD2DEG, 0.0f, 0.0f, 1.0f);
-  glRotatef(curYaw * RAD2DEG, 0.0f, 1.0f, 0.0f);
-  glRotatef(curPitch * RAD2DEG, 1.0f, 0.0f, 0.0f);
+// Pulls chunks until none are left; run by the workers and the caller
+void crowdDrainChunks(float frame)
+{
+  int numChunks = (crowd.count + CROWD_CHUNK - 1) / CROWD_CHUNK;
+  for (;;)
+  {
+    int c = __sync_fetch_and_add(&crowdNextChunk, 1);
+    if (c >= numChunks)
+      return;
+    int first = c * CROWD_CHUNK;
+    int last = first + CROWD_CHUNK < crowd.count ? first + CROWD_CHUNK : crowd.count;
+    crowdEvalRange(first, last, frame);
+  }
+}
 
-  isWireframe = 0;
-  glEnable(GL_POLYGON_OFFSET_FILL);
-  glPolygonOffset(1.0, 1.0);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  drawRecognizer();
-  glDisable(GL_POLYGON_OFFSET_FILL);
+void *crowdWorker(void *arg)
+{
+  int seen = 0;
+  for (;;)
+  {
+    pthread_mutex_lock(&crowdLock);
+    while (crowdGeneration == seen)
+      pthread_cond_wait(&crowdWake, &crowdLock);
+    seen = crowdGeneration;
+    float frame = crowdFrame;
+    pthread_mutex_unlock(&crowdLock);
 
-  isWireframe = 1;
-  glLineWidth(2.0f);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-  drawRecognizer();
+    crowdDrainChunks(frame);
 
-  glPopMatrix();
-  renderFrameCounter();
-  glutSwapBuffers();
+    pthread_mutex_lock(&crowdLock);
+    if (--crowdWorking == 0)
+      pthread_cond_signal(&crowdDone);
+    pthread_mutex_unlock(&crowdLock);
+  }
+  return NULL;
 }
 
-void specialKeys(int key, int x, int y)
+void crowdStartThreads()
 {
-  if (key == GLUT_KEY_RIGHT && currentFrame < MAX_FRAMES - 1)
-    currentFrame++;
-  else if (key == GLUT_KEY_LEFT && currentFrame > 0)
-    currentFrame--;
-  glutPostRedisplay();
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int wanted = (int)(cores > CROWD_MAX_THREADS ? CROWD_MAX_THREADS : cores) - 1; // Caller is one
+  // Only threads that actually started are waited for
+  numCrowdThreads = 0;
+  for (int i = 0; i < wanted; i++)
+    if (pthread_create(&crowdThreads[numCrowdThreads], NULL, crowdWorker, NULL) == 0)
+      numCrowdThreads++;
+  if (numCrowdThreads < wanted)
+    printf("Crowd: started %d of %d worker threads\n", numCrowdThreads, wanted);
 }
 
-void init()
+// Evaluates every craft at the given frame and refreshes crowd.transforms.
+// Returns 0 if the crowd could not be allocated.
+int crowdUpdate(float frame)
 {
-  glClearColor(0.0, 0.0, 0.0, 1.0);
-  glEnable(GL_DEPTH_TEST);
-  tess = gluNewTess();
-  gluTessCallback(tess, GLU_TESS_BEGIN, (void(CALLBACK *)())tessBeginCB);
-  gluTessCallback(tess, GLU_TESS_END, (void(CALLBACK *)())tessEndCB);
-  gluTessCallback(tess, GLU_TESS_VERTEX, (void(CALLBACK *)())tessVertexCB);
-  gluTessCallback(tess, GLU_TESS_COMBINE, (void(CALLBACK *)())tessCombineCB);
-  gluTessProperty(tess, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
+  if (crowd.count == 0)
+  {
+    if (!crowdInit(crowdSize))
+      return 0;
+    crowdStartThreads();
+  }
+  double start = traceNow();
+  traceBegin("crowd update");
+
+  pthread_mutex_lock(&crowdLock);
+  crowdFrame = frame;
+  crowdNextChunk = 0;
+  crowdWorking = numCrowdThreads;
+  crowdGeneration++;
+  pthread_cond_broadcast(&crowdWake);
+  pthread_mutex_unlock(&crowdLock);
+
+  crowdDrainChunks(frame);
+
+  pthread_mutex_lock(&crowdLock);
+  while (crowdWorking > 0)
+    pthread_cond_wait(&crowdDone, &crowdLock);
+  pthread_mutex_unlock(&crowdLock);
+
+  traceEnd("crowd update");
+  crowdShaded = 0;
+  float ms = (traceNow() - start) / 1000.0;
+  crowdSimMs = (crowdSimMs == 0.0f) ? ms : 0.9f * crowdSimMs + 0.1f * ms;
+  return 1;
 }
 
-void reshape(int w, int h)
+// Compares crowdUpdate (the SSE path where available) against
+// crowdEvalScalar for every craft at a few frames, relative to each value's
+// magnitude (positions reach a few thousand units). Returns 0 on mismatch.
+#define CROWD_CHECK_TOLERANCE 1e-5f
+
+int crowdCheck()
 {
-  if (h == 0)
-    h = 1;
-  float aspect = (float)w / (float)h;
-  glViewport(0, 0, w, h);
-  glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
-  gluPerspective(45.0, aspect, 0.1, 100.0);
-  glMatrixMode(GL_MODELVIEW);
+  float frames[] = {0.0f, 17.5f, 48.0f, 71.25f, MAX_FRAMES - 1.0f};
+  float (*simd)[16] = (float(*)[16])malloc(crowd.count * sizeof(float[16]));
+  if (!simd)
+  {
+    printf("Crowd check: out of memory\n");
+    return 0;
+  }
+  float worst = 0.0f;
+  for (int f = 0; f < (int)(sizeof(frames) / sizeof(frames[0])); f++)
+  {
+    crowdUpdate(frames[f]);
+    memcpy(simd, crowd.transforms, crowd.count * sizeof(float[16]));
+    for (int i = 0; i < crowd.count; i++)
+    {
+      crowdEvalScalar(i, frames[f]);
+      for (int k = 0; k < 16; k++)
+      {
+        float ref = crowd.transforms[i][k];
+        float err = fabsf(simd[i][k] - ref) / (fabsf(ref) > 1.0f ? fabsf(ref) : 1.0f);
+        if (!(err <= worst)) // Also catches NaN
+          worst = err;
+      }
+    }
+  }
+  free(simd);
+  int ok = worst <= CROWD_CHECK_TOLERANCE;
+  printf("Crowd check against scalar: max relative error %.2e, %s\n", worst, ok ? "ok" : "FAIL");
+  return ok;
 }
 
-int main(int argc, char **argv)
+// Checks the fast path, then times crowdUpdate over the whole animation
+// and reports the average. Returns 0 if the check failed.
+int crowdBenchmark()
 {
-  glutInit(&argc, argv);
-  glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-  glutInitWindowSize(800, 800);
-  glutCreateWindow("Tron: Recognizer");
-  init();
-  glutDisplayFunc(display);
-  glutReshapeFunc(reshape);
-  glutSpecialFunc(specialKeys);
-  glutMainLoop();
-  gluDeleteTess(tess);
-  return 0;
+  if (!crowdUpdate(0.0f)) // Allocation and thread start-up
+    return 0;
+  int ok = crowdCheck();
+  int runs = 10;
+  double start = traceNow();
+  for (int r = 0; r < runs; r++)
+    for (int f = 0; f < MAX_FRAMES; f++)
+      crowdUpdate(f);
+  double ms = (traceNow() - start) / 1000.0 / (runs * MAX_FRAMES);
+  printf("Crowd: %d crafts, %d threads + caller, %.3f ms per update\n", crowd.count, numCrowdThreads, ms);
+  return ok;
 }
+
+void renderFrameCounter()
+{
+  traceBegin("hud");
+  GLT(glMatrixMode(GL_PROJECTION));
+  GLT(glPushMatrix());
+  GLT(glLoadIdentity());
+  GLT(gluOrtho2D(0, 800, 0, 600));
+  GLT(glMatrixMode(GL_MODELVIEW));
+  GLT(glPushMatrix());
+  GLT(glLoadIdentity());
+  GLT(glColor3f(1.0f, 1.0f, 1.0f));
+  GLT(glRasterPos2i(20, 570));
+  char buffer[64];
+  if (crowdMode)
+    sprintf(buffer, "%03d  crowd %d: %.2f ms", currentFrame, crowd.count, crowdSimMs);
+  else
+    sprintf(buffer, "%03d", currentFrame);
+  for (char *c = buffer; *c != '\0'; c++)
+    GLT(glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *c));
+  GLT(glMatrixMode(GL_MODELVIEW));
+  GLT(glPopMatrix());
+  GLT(glMatrixMode(GL_PROJECTION));
+  GLT(glPopMatrix());
+  GLT(glMatrixMode(GL_MODELVIEW));
+  traceEnd("hud");
+}
+
+void drawLightVector()
+{
+  glDisable(GL_LIGHTING);
+  glDisable(GL_DEPTH_TEST);
+  glLineWidth(3.0f);
+
+  float scale = 8.0f;
+
+  glBegin(GL_LINES);
+  glColor3f(0.0f, 0.5f, 1.0f);
+  glVertex3f(0.0f, 0.0f, 0.0f);
+  glVertex3f(light.x * scale, light.y * scale, light.z * scale);
+  glEnd();
+
+  glEnable(GL_DEPTH_TEST);
+  glLineWidth(1.0f);
+}
+
+// --- STATIC SCENE ---
+// Everything that never moves (light ray, ground grid, later set dressing) is
+// compiled into one display list so it stays resident on the GL side and costs
+// a single glCallList per frame, however many lines the arena grows to.
+int gridHalfSize = 10; // Grid spans [-gridHalfSize, gridHalfSize] on X and Z
+float gridStep = 1.0f;
+GLuint staticSceneList = 0;
+
+void drawGrid()
+{
+  int lines = (int)(gridHalfSize / gridStep);
+  float extent = lines * gridStep;
+  glLineWidth(1.0f);
+  glBegin(GL_LINES);
+  glColor3f(0.15f, 0.15f, 0.15f);
+  for (int k = -lines; k <= lines; k++)
+  {
+    float i = k * gridStep;
+    glVertex3f(i, endY, extent);
+    glVertex3f(i, endY, -extent);
+    glVertex3f(extent, endY, i);
+    glVertex3f(-extent, endY, i);
+  }
+  glEnd();
+}
+
+// Call again after changing the grid or the light
+void buildStaticScene()
+{
+  if (staticSceneList == 0)
+    staticSceneList = glGenLists(1);
+  glNewList(staticSceneList, GL_COMPILE);
+  drawLightVector();
+  drawGrid();
+  glEndList();
+}
+
+void applyModelTransform()
+{
+  GLT(glTranslatef(curX, curY, curZ));
+  float rot[16];
+  quatToMatrix(curRot, rot);
+  GLT(glMultMatrixf(rot));
+}
+
+// Both passes of the baked mesh in the current modelview, the solids in
+// the given per-vertex colors
+void drawMeshArrays(float (*colors)[3])
+{
+  frameMeshDraws++;
+  // Pass 1: Solid
+  GLT(glEnable(GL_POLYGON_OFFSET_FILL));
+  GLT(glPolygonOffset(1.0, 1.0));
+  GLT(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
+  if (emissivePass)
+  {
+    // Solids only occlude in the glow layer
+    GLT(glColor3fv(colorBlack));
+    GLT(glCallList(meshSolidList));
+  }
+  else
+  {
+    GLT(glEnableClientState(GL_VERTEX_ARRAY));
+    GLT(glEnableClientState(GL_COLOR_ARRAY));
+    GLT(glVertexPointer(3, GL_FLOAT, 0, triVerts));
+    GLT(glColorPointer(3, GL_FLOAT, 0, colors));
+    GLT(glDrawArrays(GL_TRIANGLES, 0, numTriVerts));
+    GLT(glDisableClientState(GL_COLOR_ARRAY));
+    GLT(glDisableClientState(GL_VERTEX_ARRAY));
+  }
+  GLT(glDisable(GL_POLYGON_OFFSET_FILL));
+
+  // Pass 2: Wireframe
+  GLT(glLineWidth(emissivePass ? glowWireWidth : wireWidth));
+  GLT(glColor3fv(colorWire));
+  GLT(glCallList(meshWireList));
+}
+
+// Replays the baked mesh at the current pose
+void drawModel()
+{
+  traceBegin("model");
+  GLT(glPushMatrix());
+  applyModelTransform();
+  drawMeshArrays(triColors);
+  GLT(glPopMatrix());
+  traceEnd("model");
+}
+
+// Draws the first crowdDrawLimit crafts straight from the transform buffer.
+// They are shaded once per simulated frame into crowdColors, and every view
+// reuses that; the glow layer draws the solids black and needs no shading.
+void drawCrowd()
+{
+  if (!crowdColors)
+  {
+    crowdColors = (float(*)[3])malloc(crowdDrawLimit * numTriVerts * sizeof(float[3]));
+    if (!crowdColors)
+    {
+      printf("Crowd: out of memory for colors, crowd off\n");
+      crowdMode = 0;
+      return;
+    }
+  }
+  traceBegin("crowd");
+  int n = crowd.count < crowdDrawLimit ? crowd.count : crowdDrawLimit;
+  if (!crowdShaded && !emissivePass)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      float *m = crowd.transforms[i];
+      // Light in model space is R^T * light: each rotation column dotted with it
+      Vec3 c0 = {m[0], m[1], m[2]}, c1 = {m[4], m[5], m[6]}, c2 = {m[8], m[9], m[10]};
+      Vec3 local = {dotProduct(c0, light), dotProduct(c1, light), dotProduct(c2, light)};
+      shadeMeshLocal(local, crowdColors + i * numTriVerts);
+    }
+    crowdShaded = 1;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    GLT(glPushMatrix());
+    GLT(glMultMatrixf(crowd.transforms[i]));
+    drawMeshArrays(crowdColors + i * numTriVerts);
+    GLT(glPopMatrix());
+  }
+  traceEnd("crowd");
+}
+
+// --- PLANAR SHADOW ---
+// The solid triangles are squashed onto the ground plane (y = endY) along the
+// light direction by one projection matrix and drawn in a single call. The
+// stencil buffer lets each pixel darken only once where triangles overlap.
+int showShadow = 1;
+int hasStencil = 0;
+float colorShadow[] = {0.0f, 0.0f, 0.0f, 0.6f};
+
+// Projects onto the plane a*x + b*y + c*z + d = 0 from a directional light
+void planarShadowMatrix(float m[16], float a, float b, float c, float d, Vec3 l)
+{
+  float plane[4] = {a, b, c, d};
+  float dir[4] = {l.x, l.y, l.z, 0.0f};
+  float dot = a * l.x + b * l.y + c * l.z;
+  for (int col = 0; col < 4; col++)
+    for (int row = 0; row < 4; row++)
+      m[col * 4 + row] = (row == col ? dot : 0.0f) - dir[row] * plane[col];
+}
+
+void drawShadow()
+{
+  traceBegin("shadow");
+  // Lifted slightly so it sits on top of the grid lines
+  float shadow[16];
+  planarShadowMatrix(shadow, 0.0f, 1.0f, 0.0f, -(endY + 0.01f), light);
+
+  if (hasStencil)
+  {
+    GLT(glClear(GL_STENCIL_BUFFER_BIT));
+    GLT(glEnable(GL_STENCIL_TEST));
+    GLT(glStencilFunc(GL_EQUAL, 0, 0xFF));
+    GLT(glStencilOp(GL_KEEP, GL_KEEP, GL_INCR));
+  }
+  GLT(glEnable(GL_BLEND));
+  GLT(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+  GLT(glDepthMask(GL_FALSE));
+
+  GLT(glPushMatrix());
+  GLT(glMultMatrixf(shadow));
+  applyModelTransform();
+  GLT(glColor4fv(colorShadow));
+  GLT(glCallList(meshSolidList));
+  GLT(glPopMatrix());
+
+  GLT(glDepthMask(GL_TRUE));
+  GLT(glDisable(GL_BLEND));
+  GLT(glDisable(GL_STENCIL_TEST));
+  traceEnd("shadow");
+}
+
+// --- VIEWS ---
+// Split view shows the reference-drawing projections next to the normal
+// camera. The pose and face shading are computed once per frame and every
+// view just replays the same resident geometry with its own camera.
+typedef struct
+{
+  int ortho;
+  float eye[3];
+  float up[3];
+} View;
+
+View mainView = {0, {0.0f, 5.0f, 15.0f}, {0.0f, 1.0f, 0.0f}};
+View splitViews[4] = {
+    {1, {0.0f, 0.0f, 20.0f}, {0.0f, 1.0f, 0.0f}},  // Front
+    {1, {20.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},  // Side
+    {1, {0.0f, 20.0f, 0.0f}, {0.0f, 0.0f, -1.0f}}, // Top
+    {0, {0.0f, 5.0f, 15.0f}, {0.0f, 1.0f, 0.0f}},  // Perspective
+};
+int splitView = 0;
+float orthoHalfSize = 7.0f;
+int winW = 800, winH = 800;
+
+void applyView(const View *v, int x, int y, int w, int h)
+{
+  if (h == 0)
+    h = 1;
+  float aspect = (float)w / (float)h;
+  GLT(glViewport(x, y, w, h));
+  GLT(glMatrixMode(GL_PROJECTION));
+  GLT(glLoadIdentity());
+  if (v->ortho)
+    GLT(glOrtho(-orthoHalfSize * aspect, orthoHalfSize * aspect, -orthoHalfSize, orthoHalfSize, 0.1, 100.0));
+  else
+    GLT(gluPerspective(45.0, aspect, 0.1, 100.0));
+  GLT(glMatrixMode(GL_MODELVIEW));
+  GLT(glLoadIdentity());
+  GLT(gluLookAt(v->eye[0], v->eye[1], v->eye[2], 0.0, 0.0, 0.0, v->up[0], v->up[1], v->up[2]));
+}
+
+void drawView()
+{
+  traceBegin("view");
+  if (!emissivePass)
+  {
+    GLT(glCallList(staticSceneList));
+    if (showShadow)
+      drawShadow();
+  }
+  drawModel();
+  if (crowdMode)
+    drawCrowd();
+  traceEnd("view");
+}
+
+// Lays out the active views inside the (0, 0, w, h) rectangle
+void drawViews(int w, int h)
+{
+  if (splitView)
+  {
+    int hw = w / 2, hh = h / 2;
+    for (int i = 0; i < 4; i++)
+    {
+      // Top row: front, side. Bottom row: top, perspective
+      applyView(&splitViews[i], (i % 2) * hw, (i < 2) ? hh : 0, hw, hh);
+      drawView();
+    }
+  }
+  else
+  {
+    applyView(&mainView, 0, 0, w, h);
+    drawView();
+  }
+}
+
+void drawScene(float frame)
+{
+  traceBegin("scene");
+  traceBegin("pose + shade");
+  setPose(frame);
+  shadeMesh();
+  traceEnd("pose + shade");
+  GLT(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+  drawViews(winW, winH);
+  GLT(glViewport(0, 0, winW, winH));
+  traceEnd("scene");
+}
+
+// --- GLOW ---
+// Backlit bloom for the red edges. The emissive layer (wires only, occluded
+// by the solids) is rendered small, then blurred through a fixed pyramid of
+// GLOW_LEVELS half-size steps with a separable 5-tap binomial kernel, and the
+// levels are added back over the frame. Level 0 is GLOW_BASE pixels wide
+// (or the window width, if narrower) whatever the window size, and a wider
+// glow comes from the coarser levels, so the blur cost does not grow with
+// resolution or radius. The GL path works on textures copied from the back
+// buffer; on GL without non-power-of-two textures they are rounded up and
+// only the lower-left w x h region is used. cpuGlow() runs the same pyramid
+// on the read-back emissive layer (SSE when available) for exports.
+#define GLOW_LEVELS 4
+#define GLOW_BASE 256
+
+typedef struct
+{
+  GLuint id;
+  int w, h;   // Region in use
+  float s, t; // Texture coordinates of its top-right corner
+} GlowTexture;
+
+int glowEnabled = 0;
+int cpuGlowExport = 0; // Exports take the CPU path (--cpu-glow)
+int hasNPOT = 0;
+float glowStrength = 3.0f;
+float glowKernel[5] = {1.0f / 16, 4.0f / 16, 6.0f / 16, 4.0f / 16, 1.0f / 16};
+
+GlowTexture sceneTex;
+GlowTexture glowTex[GLOW_LEVELS];
+int glowAllocW = 0, glowAllocH = 0;
+
+// Size of pyramid level l for the current window. Level 0 never outgrows
+// the framebuffer it is rendered into.
+void glowLevelSize(int l, int *w, int *h)
+{
+  int base = winW < GLOW_BASE ? winW : GLOW_BASE;
+  int lw = base >> l;
+  int lh = (int)((float)lw * winH / winW);
+  *w = lw < 1 ? 1 : lw;
+  *h = lh < 1 ? 1 : lh;
+}
+
+int nextPowerOfTwo(int n)
+{
+  int p = 1;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+
+void makeGlowTexture(GlowTexture *t, int w, int h)
+{
+  int tw = hasNPOT ? w : nextPowerOfTwo(w);
+  int th = hasNPOT ? h : nextPowerOfTwo(h);
+  // Cleared, so any padding reads as black
+  unsigned char *black = (unsigned char *)calloc(tw * th, 3);
+  GLT(glGenTextures(1, &t->id));
+  GLT(glBindTexture(GL_TEXTURE_2D, t->id));
+  GLT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+  GLT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GLT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  GLT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+  GLT(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  GLT(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tw, th, 0, GL_RGB, GL_UNSIGNED_BYTE, black));
+  free(black);
+  t->w = w;
+  t->h = h;
+  t->s = (float)w / tw;
+  t->t = (float)h / th;
+}
+
+// (Re)creates the textures when the window size changes
+void allocGlowTextures()
+{
+  if (glowAllocW == winW && glowAllocH == winH)
+    return;
+  if (sceneTex.id)
+  {
+    GLT(glDeleteTextures(1, &sceneTex.id));
+    for (int l = 0; l < GLOW_LEVELS; l++)
+      GLT(glDeleteTextures(1, &glowTex[l].id));
+  }
+  makeGlowTexture(&sceneTex, winW, winH);
+  for (int l = 0; l < GLOW_LEVELS; l++)
+  {
+    int lw, lh;
+    glowLevelSize(l, &lw, &lh);
+    makeGlowTexture(&glowTex[l], lw, lh);
+  }
+  glowAllocW = winW;
+  glowAllocH = winH;
+}
+
+// Textured quad over the current viewport, shifted by (dx, dy) texels
+void drawTexQuad(const GlowTexture *t, float dx, float dy)
+{
+  float du = dx * t->s / t->w, dv = dy * t->t / t->h;
+  GLT(glBindTexture(GL_TEXTURE_2D, t->id));
+  GLT(glBegin(GL_QUADS));
+  GLT(glTexCoord2f(du, dv));
+  GLT(glVertex2f(0.0f, 0.0f));
+  GLT(glTexCoord2f(t->s + du, dv));
+  GLT(glVertex2f(1.0f, 0.0f));
+  GLT(glTexCoord2f(t->s + du, t->t + dv));
+  GLT(glVertex2f(1.0f, 1.0f));
+  GLT(glTexCoord2f(du, t->t + dv));
+  GLT(glVertex2f(0.0f, 1.0f));
+  GLT(glEnd());
+}
+
+void copyToTexture(const GlowTexture *t)
+{
+  GLT(glBindTexture(GL_TEXTURE_2D, t->id));
+  GLT(glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, t->w, t->h));
+}
+
+// One separable pass over level l, written back into its texture
+void blurGlowLevel(int l, float dx, float dy)
+{
+  GLT(glClear(GL_COLOR_BUFFER_BIT));
+  for (int k = 0; k < 5; k++)
+  {
+    GLT(glColor3f(glowKernel[k], glowKernel[k], glowKernel[k]));
+    drawTexQuad(&glowTex[l], (k - 2) * dx, (k - 2) * dy);
+  }
+  copyToTexture(&glowTex[l]);
+}
+
+// Draws the emissive layer into the lower-left w x h of the back buffer, at
+// the unblurred pose, and returns the wire width at that scale. Lines can't
+// get thinner than a pixel, so callers take any extra coverage out of the
+// intensity (scaledWidth / glowWireWidth).
+float renderEmissiveLayer(int w, int h)
+{
+  float scaledWidth = wireWidth * w / winW;
+  glowWireWidth = scaledWidth < 1.0f ? 1.0f : scaledWidth;
+  setPose(animFrame);
+  emissivePass = 1;
+  GLT(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+  drawViews(w, h);
+  emissivePass = 0;
+  return scaledWidth;
+}
+
+void glowPass()
+{
+  traceBegin("glow");
+  allocGlowTextures();
+  copyToTexture(&sceneTex);
+
+  float scaledWidth = renderEmissiveLayer(glowTex[0].w, glowTex[0].h);
+  copyToTexture(&glowTex[0]);
+
+  GLT(glMatrixMode(GL_PROJECTION));
+  GLT(glLoadIdentity());
+  GLT(glOrtho(0.0, 1.0, 0.0, 1.0, -1.0, 1.0));
+  GLT(glMatrixMode(GL_MODELVIEW));
+  GLT(glLoadIdentity());
+  GLT(glDisable(GL_DEPTH_TEST));
+  GLT(glEnable(GL_TEXTURE_2D));
+  GLT(glEnable(GL_BLEND));
+  GLT(glBlendFunc(GL_ONE, GL_ONE));
+
+  for (int l = 0; l < GLOW_LEVELS; l++)
+  {
+    GLT(glViewport(0, 0, glowTex[l].w, glowTex[l].h));
+    if (l > 0)
+    {
+      // Downsample the blurred level above (linear filtering averages 2x2)
+      GLT(glClear(GL_COLOR_BUFFER_BIT));
+      GLT(glColor3f(1.0f, 1.0f, 1.0f));
+      drawTexQuad(&glowTex[l - 1], 0.0f, 0.0f);
+      copyToTexture(&glowTex[l]);
+    }
+    blurGlowLevel(l, 1.0f, 0.0f);
+    blurGlowLevel(l, 0.0f, 1.0f);
+  }
+
+  // Composite: the frame, then every level added on top in the wire color
+  GLT(glViewport(0, 0, winW, winH));
+  GLT(glDisable(GL_BLEND));
+  GLT(glColor3f(1.0f, 1.0f, 1.0f));
+  drawTexQuad(&sceneTex, 0.0f, 0.0f);
+  GLT(glEnable(GL_BLEND));
+  float w = glowStrength / GLOW_LEVELS * scaledWidth / glowWireWidth;
+  GLT(glColor3f(colorWire[0] * w, colorWire[1] * w, colorWire[2] * w));
+  for (int l = 0; l < GLOW_LEVELS; l++)
+    drawTexQuad(&glowTex[l], 0.0f, 0.0f);
+
+  GLT(glDisable(GL_BLEND));
+  GLT(glDisable(GL_TEXTURE_2D));
+  GLT(glEnable(GL_DEPTH_TEST));
+  traceEnd("glow");
+}
+
+// --- CPU GLOW ---
+// The GL pyramid on single-channel float images. The wire color is pure red,
+// so the red channel of the emissive layer is the whole layer.
+#define GLOW_CHECK_TOLERANCE 1e-6f
+
+// One output of the 5-tap kernel at i, along a line of n values spaced
+// stride apart, clamped at the ends
+float blurAt(const float *s, int n, int stride, int i)
+{
+  float sum = 0.0f;
+  for (int k = 0; k < 5; k++)
+  {
+    int j = i + k - 2;
+    j = j < 0 ? 0 : (j >= n ? n - 1 : j);
+    sum += glowKernel[k] * s[j * stride];
+  }
+  return sum;
+}
+
+// Reference passes the SSE ones are checked against; src and dst may not alias
+void blurRowsScalar(const float *src, float *dst, int w, int h)
+{
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++)
+      dst[y * w + x] = blurAt(src + y * w, w, 1, x);
+}
+
+void blurColumnsScalar(const float *src, float *dst, int w, int h)
+{
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++)
+      dst[y * w + x] = blurAt(src + x, h, w, y);
+}
+
+// Four outputs from the five taps, using the kernel's symmetry
+#ifdef __SSE__
+__m128 blurTaps4(__m128 t0, __m128 t1, __m128 t2, __m128 t3, __m128 t4)
+{
+  __m128 a = _mm_add_ps(t0, t4), b = _mm_add_ps(t1, t3);
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(glowKernel[0])), _mm_mul_ps(b, _mm_set1_ps(glowKernel[1]))),
+                    _mm_mul_ps(t2, _mm_set1_ps(glowKernel[2])));
+}
+#endif
+
+// Separable 5-tap binomial blur with clamp-to-edge, src and dst may not alias
+void blurRows(const float *src, float *dst, int w, int h)
+{
+  for (int y = 0; y < h; y++)
+  {
+    const float *s = src + y * w;
+    float *d = dst + y * w;
+    int x = 0;
+    for (; x < 2 && x < w; x++)
+      d[x] = blurAt(s, w, 1, x);
+#ifdef __SSE__
+    // Interior: all five taps of the four outputs are inside the row
+    for (; x + 6 <= w; x += 4)
+      _mm_storeu_ps(d + x, blurTaps4(_mm_loadu_ps(s + x - 2), _mm_loadu_ps(s + x - 1), _mm_loadu_ps(s + x),
+                                     _mm_loadu_ps(s + x + 1), _mm_loadu_ps(s + x + 2)));
+#endif
+    for (; x < w; x++)
+      d[x] = blurAt(s, w, 1, x);
+  }
+}
+
+void blurColumns(const float *src, float *dst, int w, int h)
+{
+  for (int y = 0; y < h; y++)
+  {
+    float *d = dst + y * w;
+    int x = 0;
+#ifdef __SSE__
+    const float *r[5];
+    for (int k = 0; k < 5; k++)
+    {
+      int yy = y + k - 2;
+      yy = yy < 0 ? 0 : (yy >= h ? h - 1 : yy);
+      r[k] = src + yy * w;
+    }
+    for (; x + 4 <= w; x += 4)
+      _mm_storeu_ps(d + x, blurTaps4(_mm_loadu_ps(r[0] + x), _mm_loadu_ps(r[1] + x), _mm_loadu_ps(r[2] + x),
+                                     _mm_loadu_ps(r[3] + x), _mm_loadu_ps(r[4] + x)));
+#endif
+    for (; x < w; x++)
+      d[x] = blurAt(src + x, h, w, y);
+  }
+}
+
+// Bilinear sample of a single-channel image at pixel-center coordinates,
+// as GL_LINEAR with clamp-to-edge would
+float sampleGlow(const float *img, int w, int h, float x, float y)
+{
+  x = x < 0.0f ? 0.0f : (x > w - 1 ? w - 1 : x);
+  y = y < 0.0f ? 0.0f : (y > h - 1 ? h - 1 : y);
+  int x0 = (int)x, y0 = (int)y;
+  int x1 = x0 + 1 < w ? x0 + 1 : x0, y1 = y0 + 1 < h ? y0 + 1 : y0;
+  float fx = x - x0, fy = y - y0;
+  float top = img[y0 * w + x0] + (img[y0 * w + x1] - img[y0 * w + x0]) * fx;
+  float bot = img[y1 * w + x0] + (img[y1 * w + x1] - img[y1 * w + x0]) * fx;
+  return top + (bot - top) * fy;
+}
+
+// Reads back the emissive layer, blurs it through the pyramid in level[]
+// (tmp is level 0 sized scratch) and adds it to rgb
+void cpuGlowPyramid(unsigned char *rgb, float **level, const int *lw, const int *lh, float *tmp,
+                    unsigned char *emissive)
+{
+  float scaledWidth = renderEmissiveLayer(lw[0], lh[0]);
+  GLT(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+  GLT(glReadPixels(0, 0, lw[0], lh[0], GL_RED, GL_UNSIGNED_BYTE, emissive));
+  for (int i = 0; i < lw[0] * lh[0]; i++)
+    level[0][i] = emissive[i] / 255.0f;
+
+  for (int l = 0; l < GLOW_LEVELS; l++)
+  {
+    if (l > 0)
+    {
+      // Downsample the blurred level above, as linear filtering does
+      for (int y = 0; y < lh[l]; y++)
+        for (int x = 0; x < lw[l]; x++)
+          level[l][y * lw[l] + x] = sampleGlow(level[l - 1], lw[l - 1], lh[l - 1],
+                                               (x + 0.5f) * lw[l - 1] / lw[l] - 0.5f,
+                                               (y + 0.5f) * lh[l - 1] / lh[l] - 0.5f);
+    }
+    blurRows(level[l], tmp, lw[l], lh[l]);
+    blurColumns(tmp, level[l], lw[l], lh[l]);
+  }
+
+  // Composite: every level stretched over the frame in the wire color
+  float scale = glowStrength / GLOW_LEVELS * scaledWidth / glowWireWidth * 255.0f;
+  for (int y = 0; y < winH; y++)
+  {
+    unsigned char *p = rgb + y * winW * 3;
+    for (int x = 0; x < winW; x++, p += 3)
+    {
+      float g = 0.0f;
+      for (int l = 0; l < GLOW_LEVELS; l++)
+        g += sampleGlow(level[l], lw[l], lh[l], (x + 0.5f) * lw[l] / winW - 0.5f, (y + 0.5f) * lh[l] / winH - 0.5f);
+      for (int c = 0; c < 3; c++)
+      {
+        float v = p[c] + g * scale * colorWire[c];
+        p[c] = v > 255.0f ? 255 : (unsigned char)v;
+      }
+    }
+  }
+}
+
+// Applies the glow in place to a bottom-up winW x winH RGB8 frame
+// (glReadPixels layout). The emissive layer is rendered at level 0 size and
+// read back, so this blurs the same layer glowPass() does; the back buffer
+// is left holding it.
+void cpuGlow(unsigned char *rgb)
+{
+  traceBegin("cpu glow");
+  int lw[GLOW_LEVELS], lh[GLOW_LEVELS];
+  float *level[GLOW_LEVELS];
+  int ok = 1;
+  for (int l = 0; l < GLOW_LEVELS; l++)
+  {
+    glowLevelSize(l, &lw[l], &lh[l]);
+    level[l] = (float *)malloc(lw[l] * lh[l] * sizeof(float));
+    ok = ok && level[l];
+  }
+  float *tmp = (float *)malloc(lw[0] * lh[0] * sizeof(float));
+  unsigned char *emissive = (unsigned char *)malloc(lw[0] * lh[0]);
+  if (ok && tmp && emissive)
+    cpuGlowPyramid(rgb, level, lw, lh, tmp, emissive);
+  else
+    printf("Out of memory for the CPU glow, exporting without it\n");
+  for (int l = 0; l < GLOW_LEVELS; l++)
+    free(level[l]);
+  free(tmp);
+  free(emissive);
+  traceEnd("cpu glow");
+}
+
+// Runs the SSE row and column passes against the scalar ones on a
+// synthetic emissive layer, then times both at level 0 size. Needs no GL.
+// Returns 0 on mismatch.
+int glowBenchmark()
+{
+  // Not a multiple of four wide, so the scalar edges and tails are covered
+  int w = GLOW_BASE - 1, h = GLOW_BASE * 3 / 4 + 1;
+  float *src = (float *)malloc(w * h * sizeof(float));
+  float *ref = (float *)malloc(w * h * sizeof(float));
+  float *fast = (float *)malloc(w * h * sizeof(float));
+  if (!src || !ref || !fast)
+  {
+    printf("Out of memory for the glow benchmark\n");
+    free(src);
+    free(ref);
+    free(fast);
+    return 0;
+  }
+  // Thin bright lines on black, like the wire layer
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++)
+      src[y * w + x] = (x % 23 == 0 || (x + 2 * y) % 37 == 0) ? 1.0f : 0.1f + 0.1f * sinf(x * 0.37f + y * 0.11f);
+
+  float worst = 0.0f;
+  void (*passes[2][2])(const float *, float *, int, int) = {{blurRows, blurRowsScalar},
+                                                             {blurColumns, blurColumnsScalar}};
+  for (int p = 0; p < 2; p++)
+  {
+    passes[p][0](src, fast, w, h);
+    passes[p][1](src, ref, w, h);
+    for (int i = 0; i < w * h; i++)
+    {
+      float err = fabsf(fast[i] - ref[i]);
+      if (!(err <= worst)) // Also catches NaN
+        worst = err;
+    }
+  }
+  int ok = worst <= GLOW_CHECK_TOLERANCE;
+  printf("Glow check against scalar: max error %.2e, %s\n", worst, ok ? "ok" : "FAIL");
+
+  int runs = 200;
+  double us[2];
+  for (int v = 0; v < 2; v++)
+  {
+    double start = traceNow();
+    for (int r = 0; r < runs; r++)
+    {
+      passes[0][v](src, ref, w, h);
+      passes[1][v](ref, fast, w, h);
+    }
+    us[v] = (traceNow() - start) / runs;
+  }
+  printf("Glow blur, %dx%d: %.1f us per level (%s), %.1f us scalar\n", w, h, us[0],
+#ifdef __SSE__
+         "SSE",
+#else
+         "no SSE",
+#endif
+         us[1]);
+  free(src);
+  free(ref);
+  free(fast);
+  return ok;
+}
+
+// --- MOTION BLUR ---
+// Averages blurSamples poses spread over the open shutter in the accumulation
+// buffer. The mesh is already baked, so each extra sample only costs a
+// recolor plus the two model draw calls and the static scene list.
+// The accumulation buffer is part of the window visual (usually 16-bit fixed
+// point per channel, not float); without one, blur is unavailable and 'b'
+// says so.
+int blurSamples = 1;
+float shutterAngle = 0.5f; // Fraction of a frame the shutter stays open (180 deg)
+int hasAccum = 0;
+
+// --- QUALITY GOVERNOR ---
+// While playing, the render cost of each frame (smoothed) is held against the
+// budget for targetFps by stepping through qualityLevels. The cost of a frame is
+// the larger of its CPU time in display() and its GPU time from a
+// GL_TIME_ELAPSED query, which is read back one frame later so the pipeline
+// never stalls on it; neither is capped by vsync the way the swap-to-swap
+// interval is. Without timer queries the CPU time is taken up to a glFinish()
+// before the swap instead. A level is dropped
+// after a short run of over-budget frames and raised only after a much longer
+// run with clear headroom, so it does not oscillate around the target.
+// Knobs the user sets by hand (b, h, w) are pinned and left alone.
+// Every change is logged with the timing that caused it.
+typedef struct
+{
+  const char *name;
+  int blurSamples;
+  int shadow;
+  float wireWidth;
+  float gridStep;
+  int multisample;
+  int glow;
+} QualityLevel;
+
+QualityLevel qualityLevels[] = {
+    {"minimal", 1, 0, 1.0f, 2.0f, 0, 0},
+    {"low", 1, 1, 1.0f, 1.0f, 0, 0},
+    {"medium", 1, 1, 2.0f, 1.0f, 0, 0}, // Default look
+    {"high", 1, 1, 2.0f, 1.0f, 1, 1},
+    {"ultra", 4, 1, 2.0f, 0.5f, 1, 1},
+};
+#define NUM_QUALITY_LEVELS (int)(sizeof(qualityLevels) / sizeof(qualityLevels[0]))
+#define GOVERNOR_OVER 1.1f      // Budget fraction that counts as too slow
+#define GOVERNOR_HEADROOM 0.6f  // Budget fraction that counts as room to spare
+#define GOVERNOR_DROP_FRAMES 6  // Consecutive slow frames before dropping
+#define GOVERNOR_RAISE_FRAMES 48 // Consecutive fast frames before raising
+
+int governorEnabled = 0;
+float targetFps = 24.0f;
+int qualityLevel = 2;
+int hasMultisample = 0;
+float smoothedMs = 0.0f;
+int slowFrames = 0;
+int fastFrames = 0;
+int pinnedBlur = 0;
+int pinnedShadow = 0;
+int pinnedGlow = 0;
+int hasTimerQuery = 0;
+GLuint frameQueries[2];   // Ping-pong GL_TIME_ELAPSED queries
+int frameQueryPending[2]; // Issued and not yet read back
+float frameQueryCpuMs[2]; // CPU time of the frame each query timed
+int frameQueryNext = 0;
+int frameQueryWarm = 0;   // The first result of a run has been dropped
+
+void applyQuality(int level)
+{
+  QualityLevel *q = &qualityLevels[level];
+  qualityLevel = level;
+  if (!pinnedBlur)
+    blurSamples = q->blurSamples;
+  if (!pinnedShadow)
+    showShadow = q->shadow;
+  if (!pinnedGlow)
+    glowEnabled = q->glow;
+  wireWidth = q->wireWidth;
+  if (hasMultisample)
+  {
+    if (q->multisample)
+      glEnable(GL_MULTISAMPLE);
+    else
+      glDisable(GL_MULTISAMPLE);
+  }
+  if (q->gridStep != gridStep)
+  {
+    gridStep = q->gridStep;
+    buildStaticScene();
+  }
+}
+
+// Lists the knobs the governor is leaving alone, for its log lines
+const char *pinnedKnobs()
+{
+  static char buf[48];
+  buf[0] = '\0';
+  if (pinnedBlur)
+    strcat(buf, " blur");
+  if (pinnedShadow)
+    strcat(buf, " shadow");
+  if (pinnedGlow)
+    strcat(buf, " glow");
+  return buf;
+}
+
+// Called at the top of display(): starts timing the frame's GPU work
+void governorBeginFrame()
+{
+  if (!governorEnabled || !isPlaying || !hasTimerQuery)
+    return;
+  if (!frameQueries[0])
+    GLT(glGenQueries(2, frameQueries));
+  GLT(glBeginQuery(GL_TIME_ELAPSED, frameQueries[frameQueryNext]));
+}
+
+// Called after the frame is drawn and before the swap; frameStartUs is
+// traceNow() at the top of display(). New levels take effect next frame.
+void governorUpdate(double frameStartUs)
+{
+  if (!governorEnabled || !isPlaying)
+  {
+    smoothedMs = 0.0f;
+    frameQueryPending[0] = frameQueryPending[1] = 0;
+    frameQueryWarm = 0;
+    return;
+  }
+  float ms;
+  if (hasTimerQuery)
+  {
+    // End this frame's query and score the previous frame, whose result the
+    // GPU has had a whole frame to deliver
+    int cur = frameQueryNext, prev = 1 - cur;
+    GLT(glEndQuery(GL_TIME_ELAPSED));
+    frameQueryCpuMs[cur] = (traceNow() - frameStartUs) / 1000.0;
+    frameQueryPending[cur] = 1;
+    frameQueryNext = prev;
+    if (!frameQueryPending[prev])
+      return;
+    GLuint64 gpuNs = 0;
+    GLT(glGetQueryObjectui64v(frameQueries[prev], GL_QUERY_RESULT, &gpuNs));
+    frameQueryPending[prev] = 0;
+    // Some drivers (llvmpipe) time the first query from zero
+    if (!frameQueryWarm)
+    {
+      frameQueryWarm = 1;
+      return;
+    }
+    ms = fmaxf(frameQueryCpuMs[prev], gpuNs / 1e6f);
+  }
+  else
+  {
+    GLT(glFinish());
+    ms = (traceNow() - frameStartUs) / 1000.0;
+  }
+  smoothedMs = (smoothedMs == 0.0f) ? ms : 0.9f * smoothedMs + 0.1f * ms;
+
+  float budget = 1000.0f / targetFps;
+  if (smoothedMs > budget * GOVERNOR_OVER)
+  {
+    slowFrames++;
+    fastFrames = 0;
+  }
+  else if (smoothedMs < budget * GOVERNOR_HEADROOM)
+  {
+    fastFrames++;
+    slowFrames = 0;
+  }
+  else
+  {
+    slowFrames = 0;
+    fastFrames = 0;
+  }
+
+  int next = qualityLevel;
+  if (slowFrames >= GOVERNOR_DROP_FRAMES && qualityLevel > 0)
+    next = qualityLevel - 1;
+  else if (fastFrames >= GOVERNOR_RAISE_FRAMES && qualityLevel < NUM_QUALITY_LEVELS - 1)
+    next = qualityLevel + 1;
+  if (next == qualityLevel)
+    return;
+
+  printf("[governor %7.2fs] frame %03d: %.1f ms render vs %.1f ms budget, %s -> %s%s%s\n",
+         glutGet(GLUT_ELAPSED_TIME) / 1000.0f, currentFrame, smoothedMs, budget,
+         qualityLevels[qualityLevel].name, qualityLevels[next].name,
+         pinnedKnobs()[0] ? ", pinned:" : "", pinnedKnobs());
+  applyQuality(next);
+  // Re-measure from scratch at the new level
+  smoothedMs = 0.0f;
+  slowFrames = 0;
+  fastFrames = 0;
+}
+
+// The scene at the playhead, motion blurred if enabled. The crowd is
+// simulated once per frame, not per blur sample, so only the hero blurs.
+void renderScene()
+{
+  if (crowdMode && !crowdUpdate(animFrame))
+    crowdMode = 0;
+  if (blurSamples > 1 && hasAccum)
+  {
+    GLT(glClear(GL_ACCUM_BUFFER_BIT));
+    for (int k = 0; k < blurSamples; k++)
+    {
+      float offset = shutterAngle * ((k + 0.5f) / blurSamples - 0.5f);
+      drawScene(animFrame + offset);
+      GLT(glAccum(GL_ACCUM, 1.0f / blurSamples));
+    }
+    GLT(glAccum(GL_RETURN, 1.0f));
+  }
+  else
+  {
+    drawScene(animFrame);
+  }
+}
+
+// --- SHARED-MEMORY FRAME RING ---
+// --shm NAME publishes every displayed frame (before the HUD) into a POSIX
+// shared-memory ring so a compositor or encoder can map it in place.
+// One producer, one consumer: the producer only advances writeIndex, the
+// consumer only advances readIndex, and slot i % numSlots belongs to the
+// side whose index has not passed it. When the consumer falls behind,
+// frames are dropped rather than stalling the renderer.
+// With pixel buffer objects the read-back is asynchronous: each frame is
+// read into one of two PBOs and the previous frame's PBO, finished by
+// then, is copied into the ring, so frames arrive one frame late but the
+// pipeline never waits on glReadPixels. When nothing is playing there may
+// be no next frame for a long time, so the read-back is collected at once,
+// and the ring is flushed before it is closed. Without PBOs the read goes
+// straight into the slot and does stall.
+// The ring is rebuilt when the window is resized; the old one is marked
+// closed first, so consumers know to map the new one.
+#define SHM_MAGIC 0x47525254 // "TRRG"
+#define SHM_VERSION 2
+#define SHM_SLOTS 4
+
+typedef struct
+{
+  unsigned int magic, version;
+  unsigned int width, height;  // Fixed for the life of the ring
+  unsigned int stride;         // Bytes per row: RGBA8, rows bottom-up as GL reads them
+  unsigned int numSlots;
+  unsigned int slotBytes;      // Slot i starts at sizeof(ShmRingHeader) + i * slotBytes
+  unsigned int pixelOffset;    // From the slot start to its pixels
+  unsigned long long dropped;  // Frames skipped because the ring was full
+  volatile unsigned int closed; // Set when the producer resizes or exits
+  unsigned int producerPid;     // To notice a producer that died without closing
+  char pad0[64 - 48];
+  volatile unsigned long long writeIndex; // Frames published; own cache line
+  char pad1[64 - 8];
+  volatile unsigned long long readIndex; // Frames consumed
+  char pad2[64 - 8];
+} ShmRingHeader;
+
+typedef struct
+{
+  unsigned long long sequence; // Position in the ring's stream
+  int frame;                   // 24 fps animation frame
+  float animFrame;             // Continuous playhead
+  double timestampUs;          // CLOCK_MONOTONIC when rendered, as traceNow()
+  float x, y, z;               // Pose drawn
+  Quat rot;
+} ShmFrameMeta;
+
+ShmRingHeader *shmRing = NULL;
+size_t shmBytes = 0;
+const char *shmName = NULL;
+int hasPBO = 0;
+GLuint shmPBO[2];
+int shmPBOPending[2];          // PBO holds a frame not yet copied to the ring
+ShmFrameMeta shmPBOMeta[2];    // And that frame's metadata
+int shmPBONext = 0;
+
+ShmFrameMeta *shmSlotMeta(ShmRingHeader *ring, unsigned long long index)
+{
+  return (ShmFrameMeta *)((char *)ring + sizeof(ShmRingHeader) + (index % ring->numSlots) * ring->slotBytes);
+}
+
+void shmCollectPBO(int i);
+
+// Needs the GL context for the last read-back: called on resize, from
+// glutCloseFunc where GLUT has one, and at exit
+void shmClose()
+{
+  if (!shmRing)
+    return;
+  if (hasPBO)
+  {
+    // Oldest first
+    shmCollectPBO(shmPBONext);
+    shmCollectPBO(shmPBONext ^ 1);
+    GLT(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  }
+  shmRing->closed = 1;
+  munmap(shmRing, shmBytes);
+  shm_unlink(shmName);
+  shmRing = NULL;
+}
+
+// Creates the ring for a w x h frame, replacing any previous one
+int shmOpen(const char *name, int w, int h)
+{
+  static int registered = 0;
+  shmClose();
+  unsigned int pixelOffset = 64;
+  unsigned int slotBytes = (pixelOffset + w * h * 4 + 4095) & ~4095u;
+  shmBytes = sizeof(ShmRingHeader) + (size_t)slotBytes * SHM_SLOTS;
+
+  int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+  if (fd < 0 || ftruncate(fd, shmBytes) != 0)
+  {
+    perror(name);
+    if (fd >= 0)
+      close(fd);
+    return 0;
+  }
+  void *mem = mmap(NULL, shmBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED)
+  {
+    perror(name);
+    shm_unlink(name);
+    return 0;
+  }
+
+  shmRing = (ShmRingHeader *)mem;
+  shmName = name;
+  shmRing->width = w;
+  shmRing->height = h;
+  shmRing->stride = w * 4;
+  shmRing->numSlots = SHM_SLOTS;
+  shmRing->slotBytes = slotBytes;
+  shmRing->pixelOffset = pixelOffset;
+  shmRing->producerPid = getpid();
+  shmRing->version = SHM_VERSION;
+  __sync_synchronize();
+  shmRing->magic = SHM_MAGIC; // Last, so a consumer never sees a half-built header
+  if (!registered)
+    atexit(shmClose);
+  registered = 1;
+
+  if (hasPBO)
+  {
+    if (!shmPBO[0])
+      glGenBuffers(2, shmPBO);
+    for (int i = 0; i < 2; i++)
+    {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, shmPBO[i]);
+      glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)w * h * 4, NULL, GL_STREAM_READ);
+      shmPBOPending[i] = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  printf("Frame ring /dev/shm%s: %d slots of %dx%d RGBA, %s read-back\n", name, SHM_SLOTS, w, h,
+         hasPBO ? "PBO" : "synchronous");
+  return 1;
+}
+
+// The next free slot, or NULL (and a drop) when the consumer is behind
+ShmFrameMeta *shmClaimSlot()
+{
+  unsigned long long index = shmRing->writeIndex;
+  unsigned long long consumed = shmRing->readIndex;
+  __sync_synchronize(); // Read the consumer's index before reusing its slot
+  if (index - consumed >= shmRing->numSlots)
+  {
+    shmRing->dropped++;
+    return NULL;
+  }
+  return shmSlotMeta(shmRing, index);
+}
+
+// Hands a filled slot to the consumer
+void shmCommitSlot(ShmFrameMeta *slot, const ShmFrameMeta *meta)
+{
+  unsigned long long index = shmRing->writeIndex;
+  *slot = *meta;
+  slot->sequence = index;
+  __sync_synchronize(); // Pixels and metadata land before the slot is handed over
+  shmRing->writeIndex = index + 1;
+}
+
+// Copies PBO i into the ring if it holds a frame that is not there yet
+void shmCollectPBO(int i)
+{
+  if (!shmPBOPending[i])
+    return;
+  shmPBOPending[i] = 0;
+  ShmFrameMeta *slot = shmClaimSlot();
+  if (!slot)
+    return;
+  GLT(glBindBuffer(GL_PIXEL_PACK_BUFFER, shmPBO[i]));
+  void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pixels)
+  {
+    memcpy((char *)slot + shmRing->pixelOffset, pixels, (size_t)shmRing->stride * shmRing->height);
+    GLT(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    shmCommitSlot(slot, &shmPBOMeta[i]);
+  }
+}
+
+void shmPublishFrame()
+{
+  if (!shmRing)
+    return;
+  if (winW != (int)shmRing->width || winH != (int)shmRing->height)
+  {
+    if (!shmOpen(shmName, winW, winH))
+      return;
+  }
+
+  traceBegin("shm publish");
+  // The pose at the playhead; with motion blur, cur* hold the last sub-sample
+  setPose(animFrame);
+  ShmFrameMeta meta;
+  meta.frame = (int)animFrame;
+  meta.animFrame = animFrame;
+  meta.timestampUs = traceNow();
+  meta.x = curX;
+  meta.y = curY;
+  meta.z = curZ;
+  meta.rot = curRot;
+  GLT(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+
+  if (!hasPBO)
+  {
+    ShmFrameMeta *slot = shmClaimSlot();
+    if (slot)
+    {
+      GLT(glReadPixels(0, 0, winW, winH, GL_RGBA, GL_UNSIGNED_BYTE, (char *)slot + shmRing->pixelOffset));
+      shmCommitSlot(slot, &meta);
+    }
+    traceEnd("shm publish");
+    return;
+  }
+
+  // Start this frame's read-back, then collect the previous one
+  int cur = shmPBONext, prev = cur ^ 1;
+  GLT(glBindBuffer(GL_PIXEL_PACK_BUFFER, shmPBO[cur]));
+  GLT(glReadPixels(0, 0, winW, winH, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+  shmPBOPending[cur] = 1;
+  shmPBOMeta[cur] = meta;
+  shmPBONext = prev;
+  shmCollectPBO(prev);
+  // Paused, stopped or scrubbing: no next frame is coming to collect this one
+  if (!isPlaying)
+    shmCollectPBO(cur);
+  GLT(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  traceEnd("shm publish");
+}
+
+// Maps an existing ring; returns NULL if there is none (yet) under name
+ShmRingHeader *shmMap(const char *name, size_t *bytes)
+{
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  void *mem = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmRingHeader))
+    mem = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED)
+    return NULL;
+  ShmRingHeader *ring = (ShmRingHeader *)mem;
+  if (ring->magic != SHM_MAGIC || ring->version != SHM_VERSION || ring->closed)
+  {
+    munmap(mem, st.st_size);
+    return NULL;
+  }
+  *bytes = st.st_size;
+  return ring;
+}
+
+// Reference consumer for --shm-consume NAME: maps the ring, takes frames
+// as they arrive and reports rate, latency and drops once a second. It
+// follows the producer to a rebuilt ring and exits once the producer is gone.
+#define SHM_REOPEN_MS 2000
+
+int shmConsume(const char *name)
+{
+  size_t bytes = 0;
+  ShmRingHeader *ring = shmMap(name, &bytes);
+  if (!ring)
+  {
+    printf("%s is not an open frame ring\n", name);
+    return 1;
+  }
+  printf("Consuming %s: %d slots of %dx%d\n", name, ring->numSlots, ring->width, ring->height);
+  fflush(stdout);
+
+  int frames = 0, total = 0;
+  double latency = 0.0;
+  double reportAt = traceNow() + 1e6;
+  for (;;)
+  {
+    unsigned long long index = ring->readIndex;
+    if (ring->writeIndex == index)
+    {
+      int producerGone = kill(ring->producerPid, 0) != 0 && errno == ESRCH;
+      if (ring->closed || producerGone)
+      {
+        // Resized (a new ring appears under the same name) or exited
+        munmap(ring, bytes);
+        ring = NULL;
+        for (int waited = 0; !producerGone && !ring && waited < SHM_REOPEN_MS; waited += 10)
+        {
+          usleep(10000);
+          ring = shmMap(name, &bytes);
+        }
+        if (!ring)
+        {
+          printf("Producer closed %s after %d frames\n", name, total);
+          return 0;
+        }
+        printf("Ring rebuilt: %dx%d\n", ring->width, ring->height);
+        fflush(stdout);
+        continue;
+      }
+      usleep(500);
+    }
+    else
+    {
+      __sync_synchronize(); // See the slot contents the producer published
+      ShmFrameMeta *meta = shmSlotMeta(ring, index);
+      unsigned char *pixels = (unsigned char *)meta + ring->pixelOffset;
+      latency += traceNow() - meta->timestampUs;
+      frames++;
+      if (++total == 1)
+        printf("First frame %d, centre pixel %d %d %d\n", meta->frame,
+               pixels[(ring->height / 2 * ring->width + ring->width / 2) * 4],
+               pixels[(ring->height / 2 * ring->width + ring->width / 2) * 4 + 1],
+               pixels[(ring->height / 2 * ring->width + ring->width / 2) * 4 + 2]);
+      __sync_synchronize(); // Done with the slot before giving it back
+      ring->readIndex = index + 1;
+    }
+
+    if (traceNow() >= reportAt)
+    {
+      printf("%d frames/s, latency %.2f ms, %llu dropped\n", frames,
+             frames ? latency / frames / 1000.0 : 0.0, ring->dropped);
+      fflush(stdout);
+      frames = 0;
+      latency = 0.0;
+      reportAt += 1e6;
+    }
+  }
+  return 0;
+}
+
+void display()
+{
+  double frameStart = traceNow();
+  traceBegin("frame");
+  governorBeginFrame();
+  renderScene();
+  if (glowEnabled)
+    glowPass();
+  shmPublishFrame();
+
+  renderFrameCounter();
+  governorUpdate(frameStart);
+  traceBegin("swap");
+  glutSwapBuffers();
+  traceEnd("swap");
+  traceEnd("frame");
+  traceFrameEnd();
+}
+
+// Export file name for a playhead position: recognizer_040.svg on a 24 fps
+// sample, recognizer_040.60.svg between samples
+void exportPath(char *path, size_t size, float frame, const char *ext)
+{
+  if (frame == floorf(frame))
+    snprintf(path, size, "recognizer_%03d.%s", (int)frame, ext);
+  else
+    snprintf(path, size, "recognizer_%06.2f.%s", frame, ext);
+}
+
+// --- RASTER EXPORT ---
+// Renders a frame exactly as display() would (minus the HUD) and reads it
+// back, so exported frames match the screen, glow included. With --cpu-glow
+// the glow is added to the read-back frame by cpuGlow() instead.
+void exportRasterFrame(float frame)
+{
+  float wasFrame = animFrame;
+  animFrame = frame;
+  renderScene();
+  if (glowEnabled && !cpuGlowExport)
+    glowPass();
+
+  unsigned char *rgb = (unsigned char *)malloc(winW * winH * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, winW, winH, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+  if (glowEnabled && cpuGlowExport)
+    cpuGlow(rgb);
+  animFrame = wasFrame;
+
+  char path[64];
+  exportPath(path, sizeof(path), frame, "ppm");
+  FILE *f = fopen(path, "wb");
+  if (f)
+  {
+    fprintf(f, "P6\n%d %d\n255\n", winW, winH);
+    for (int y = winH - 1; y >= 0; y--)
+      fwrite(rgb + y * winW * 3, 1, winW * 3, f);
+    fclose(f);
+  }
+  else
+  {
+    printf("Cannot write %s\n", path);
+  }
+  free(rgb);
+}
+
+// --- VECTOR EXPORT ---
+// Writes the wire pass of one frame as SVG + PDF line art for print/plotter.
+// Edges are projected with the main camera and hidden-line removal is done
+// analytically: each edge is clipped against the solid triangles in screen
+// space and dropped wherever it lies behind one. A coarse screen grid of
+// triangle bins keeps the edge/triangle tests local.
+#define EXPORT_W 800
+#define EXPORT_H 800
+#define HLR_GRID 32
+#define HLR_MAX_BIN 512
+#define HLR_EPS 1e-3    // Pixels a point must be inside a triangle to be hidden
+#define HLR_DEPTH_EPS 1e-7
+#define HLR_MIN_LEN 0.01 // Shorter visible pieces are dropped
+
+typedef struct
+{
+  double x, y, z; // Window coordinates, z is depth in [0, 1]
+} ScreenPt;
+
+typedef struct
+{
+  double x0, y0, x1, y1;
+} Segment;
+
+ScreenPt hlrTris[MAX_MESH_VERTS];
+ScreenPt hlrLines[MAX_MESH_VERTS];
+int hlrBins[HLR_GRID][HLR_GRID][HLR_MAX_BIN];
+int hlrBinCount[HLR_GRID][HLR_GRID];
+int hlrStamp[MAX_MESH_VERTS / 3];
+Segment hlrOut[MAX_MESH_VERTS * 4];
+int numHlrOut = 0;
+double hlrMinX, hlrMinY, hlrCellW, hlrCellH;
+
+void projectMesh()
+{
+  GLdouble model[16], proj[16];
+  GLint vp[4] = {0, 0, EXPORT_W, EXPORT_H};
+
+  applyView(&mainView, 0, 0, EXPORT_W, EXPORT_H);
+  glPushMatrix();
+  applyModelTransform();
+  glGetDoublev(GL_MODELVIEW_MATRIX, model);
+  glPopMatrix();
+  glGetDoublev(GL_PROJECTION_MATRIX, proj);
+
+  for (int i = 0; i < numTriVerts; i++)
+    gluProject(triVerts[i][0], triVerts[i][1], triVerts[i][2], model, proj, vp, &hlrTris[i].x, &hlrTris[i].y, &hlrTris[i].z);
+  for (int i = 0; i < numLineVerts; i++)
+    gluProject(lineVerts[i][0], lineVerts[i][1], lineVerts[i][2], model, proj, vp, &hlrLines[i].x, &hlrLines[i].y, &hlrLines[i].z);
+}
+
+int hlrCell(double v, double minV, double cell)
+{
+  int c = (int)((v - minV) / cell);
+  if (c < 0)
+    return 0;
+  if (c >= HLR_GRID)
+    return HLR_GRID - 1;
+  return c;
+}
+
+void binTriangles()
+{
+  double maxX = hlrTris[0].x, maxY = hlrTris[0].y;
+  hlrMinX = hlrTris[0].x;
+  hlrMinY = hlrTris[0].y;
+  for (int i = 1; i < numTriVerts; i++)
+  {
+    hlrMinX = fmin(hlrMinX, hlrTris[i].x);
+    hlrMinY = fmin(hlrMinY, hlrTris[i].y);
+    maxX = fmax(maxX, hlrTris[i].x);
+    maxY = fmax(maxY, hlrTris[i].y);
+  }
+  hlrCellW = (maxX - hlrMinX) / HLR_GRID + 1e-9;
+  hlrCellH = (maxY - hlrMinY) / HLR_GRID + 1e-9;
+
+  for (int gx = 0; gx < HLR_GRID; gx++)
+    for (int gy = 0; gy < HLR_GRID; gy++)
+      hlrBinCount[gx][gy] = 0;
+
+  for (int t = 0; t < numTriVerts / 3; t++)
+  {
+    ScreenPt *p = &hlrTris[t * 3];
+    int cx0 = hlrCell(fmin(p[0].x, fmin(p[1].x, p[2].x)), hlrMinX, hlrCellW);
+    int cx1 = hlrCell(fmax(p[0].x, fmax(p[1].x, p[2].x)), hlrMinX, hlrCellW);
+    int cy0 = hlrCell(fmin(p[0].y, fmin(p[1].y, p[2].y)), hlrMinY, hlrCellH);
+    int cy1 = hlrCell(fmax(p[0].y, fmax(p[1].y, p[2].y)), hlrMinY, hlrCellH);
+    for (int gx = cx0; gx <= cx1; gx++)
+      for (int gy = cy0; gy <= cy1; gy++)
+        if (hlrBinCount[gx][gy] < HLR_MAX_BIN)
+          hlrBins[gx][gy][hlrBinCount[gx][gy]++] = t;
+  }
+}
+
+// Parameter range [*t0, *t1] of a -> b that is strictly inside triangle p and
+// behind it. Returns 0 if there is none.
+int hiddenInterval(ScreenPt a, ScreenPt b, const ScreenPt *p, double *t0, double *t1)
+{
+  double area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+  if (fabs(area) < 1e-9)
+    return 0; // Edge-on, covers nothing
+  double sign = area > 0 ? 1.0 : -1.0;
+
+  double lo = 0.0, hi = 1.0;
+  for (int e = 0; e < 3; e++)
+  {
+    ScreenPt q0 = p[e], q1 = p[(e + 1) % 3];
+    double nx = -(q1.y - q0.y) * sign, ny = (q1.x - q0.x) * sign;
+    double len = sqrt(nx * nx + ny * ny);
+    // Signed distance (pixels) from this triangle edge, positive inside
+    double fa = ((a.x - q0.x) * nx + (a.y - q0.y) * ny) / len - HLR_EPS;
+    double fb = ((b.x - q0.x) * nx + (b.y - q0.y) * ny) / len - HLR_EPS;
+    if (fa < 0 && fb < 0)
+      return 0;
+    if (fa < 0)
+      lo = fmax(lo, fa / (fa - fb));
+    else if (fb < 0)
+      hi = fmin(hi, fa / (fa - fb));
+  }
+
+  // Window depth is affine across the triangle and along the edge, so the
+  // edge-minus-triangle depth difference is linear in t
+  double det = area;
+  double dzdx = ((p[1].z - p[0].z) * (p[2].y - p[0].y) - (p[2].z - p[0].z) * (p[1].y - p[0].y)) / det;
+  double dzdy = ((p[2].z - p[0].z) * (p[1].x - p[0].x) - (p[1].z - p[0].z) * (p[2].x - p[0].x)) / det;
+  double da = a.z - (p[0].z + (a.x - p[0].x) * dzdx + (a.y - p[0].y) * dzdy) - HLR_DEPTH_EPS;
+  double db = b.z - (p[0].z + (b.x - p[0].x) * dzdx + (b.y - p[0].y) * dzdy) - HLR_DEPTH_EPS;
+  if (da <= 0 && db <= 0)
+    return 0;
+  if (da <= 0)
+    lo = fmax(lo, da / (da - db));
+  else if (db <= 0)
+    hi = fmin(hi, da / (da - db));
+
+  if (hi - lo <= 0.0)
+    return 0;
+  *t0 = lo;
+  *t1 = hi;
+  return 1;
+}
+
+int compareIntervals(const void *a, const void *b)
+{
+  double d = ((const double *)a)[0] - ((const double *)b)[0];
+  return (d > 0) - (d < 0);
+}
+
+void emitVisible(ScreenPt a, ScreenPt b, double t0, double t1)
+{
+  double dx = b.x - a.x, dy = b.y - a.y;
+  if ((t1 - t0) * sqrt(dx * dx + dy * dy) < HLR_MIN_LEN || numHlrOut >= MAX_MESH_VERTS * 4)
+    return;
+  Segment *s = &hlrOut[numHlrOut++];
+  s->x0 = a.x + dx * t0;
+  s->y0 = a.y + dy * t0;
+  s->x1 = a.x + dx * t1;
+  s->y1 = a.y + dy * t1;
+}
+
+int sameSegment(const ScreenPt *a, const ScreenPt *b)
+{
+  return (a[0].x == b[0].x && a[0].y == b[0].y && a[1].x == b[1].x && a[1].y == b[1].y) ||
+         (a[0].x == b[1].x && a[0].y == b[1].y && a[1].x == b[0].x && a[1].y == b[0].y);
+}
+
+void removeHiddenLines()
+{
+  static double intervals[MAX_MESH_VERTS / 3][2];
+  numHlrOut = 0;
+  for (int t = 0; t < numTriVerts / 3; t++)
+    hlrStamp[t] = -1;
+
+  for (int e = 0; e < numLineVerts; e += 2)
+  {
+    ScreenPt a = hlrLines[e], b = hlrLines[e + 1];
+
+    // Cap loops and side loops share edges; plot each one once
+    int dup = 0;
+    for (int k = 0; k < e && !dup; k += 2)
+      dup = sameSegment(&hlrLines[k], &hlrLines[e]);
+    if (dup)
+      continue;
+
+    int n = 0;
+    int cx0 = hlrCell(fmin(a.x, b.x), hlrMinX, hlrCellW), cx1 = hlrCell(fmax(a.x, b.x), hlrMinX, hlrCellW);
+    int cy0 = hlrCell(fmin(a.y, b.y), hlrMinY, hlrCellH), cy1 = hlrCell(fmax(a.y, b.y), hlrMinY, hlrCellH);
+    for (int gx = cx0; gx <= cx1; gx++)
+      for (int gy = cy0; gy <= cy1; gy++)
+        for (int i = 0; i < hlrBinCount[gx][gy]; i++)
+        {
+          int t = hlrBins[gx][gy][i];
+          if (hlrStamp[t] == e)
+            continue;
+          hlrStamp[t] = e;
+          if (hiddenInterval(a, b, &hlrTris[t * 3], &intervals[n][0], &intervals[n][1]))
+            n++;
+        }
+
+    qsort(intervals, n, sizeof(intervals[0]), compareIntervals);
+    double cursor = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+      if (intervals[i][0] > cursor)
+        emitVisible(a, b, cursor, intervals[i][0]);
+      cursor = fmax(cursor, intervals[i][1]);
+    }
+    if (cursor < 1.0)
+      emitVisible(a, b, cursor, 1.0);
+  }
+}
+
+void writeSVG(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+  {
+    printf("Cannot write %s\n", path);
+    return;
+  }
+  fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+          EXPORT_W, EXPORT_H, EXPORT_W, EXPORT_H);
+  fprintf(f, "<path fill=\"none\" stroke=\"#ff0000\" stroke-width=\"2\" stroke-linecap=\"round\" d=\"");
+  for (int i = 0; i < numHlrOut; i++)
+  {
+    // SVG is y-down, window coordinates are y-up
+    fprintf(f, "M%.2f %.2fL%.2f %.2f", hlrOut[i].x0, EXPORT_H - hlrOut[i].y0, hlrOut[i].x1, EXPORT_H - hlrOut[i].y1);
+  }
+  fprintf(f, "\"/>\n</svg>\n");
+  fclose(f);
+}
+
+void writePDF(const char *path)
+{
+  FILE *f = fopen(path, "wb");
+  if (!f)
+  {
+    printf("Cannot write %s\n", path);
+    return;
+  }
+  long offsets[6];
+  fprintf(f, "%%PDF-1.4\n");
+  offsets[1] = ftell(f);
+  fprintf(f, "1 0 obj << /Type /Catalog /Pages 2 0 R >> endobj\n");
+  offsets[2] = ftell(f);
+  fprintf(f, "2 0 obj << /Type /Pages /Kids [3 0 R] /Count 1 >> endobj\n");
+  offsets[3] = ftell(f);
+  fprintf(f, "3 0 obj << /Type /Page /Parent 2 0 R /MediaBox [0 0 %d %d] /Contents 4 0 R >> endobj\n", EXPORT_W, EXPORT_H);
+
+  // Stream length is written afterwards as an indirect object
+  offsets[4] = ftell(f);
+  fprintf(f, "4 0 obj << /Length 5 0 R >>\nstream\n");
+  long start = ftell(f);
+  fprintf(f, "1 0 0 RG 2 w 1 J\n");
+  for (int i = 0; i < numHlrOut; i++)
+    fprintf(f, "%.2f %.2f m %.2f %.2f l S\n", hlrOut[i].x0, hlrOut[i].y0, hlrOut[i].x1, hlrOut[i].y1);
+  long length = ftell(f) - start;
+  fprintf(f, "endstream\nendobj\n");
+  offsets[5] = ftell(f);
+  fprintf(f, "5 0 obj %ld endobj\n", length);
+
+  long xref = ftell(f);
+  fprintf(f, "xref\n0 6\n0000000000 65535 f \n");
+  for (int i = 1; i <= 5; i++)
+    fprintf(f, "%010ld 00000 n \n", offsets[i]);
+  fprintf(f, "trailer << /Size 6 /Root 1 0 R >>\nstartxref\n%ld\n%%%%EOF\n", xref);
+  fclose(f);
+}
+
+void exportVectorFrame(float frame)
+{
+  char path[64];
+  setPose(frame);
+  projectMesh();
+  binTriangles();
+  removeHiddenLines();
+
+  exportPath(path, sizeof(path), frame, "svg");
+  writeSVG(path);
+  exportPath(path, sizeof(path), frame, "pdf");
+  writePDF(path);
+}
+
+void exportAllFrames()
+{
+  int startMs = glutGet(GLUT_ELAPSED_TIME);
+  for (int f = 0; f < MAX_FRAMES; f++)
+    exportVectorFrame(f);
+  printf("Exported %d frames in %d ms\n", MAX_FRAMES, glutGet(GLUT_ELAPSED_TIME) - startMs);
+}
+
+void specialKeys(int key, int x, int y)
+{
+  if (key == GLUT_KEY_RIGHT && currentFrame < MAX_FRAMES - 1)
+    currentFrame++;
+  else if (key == GLUT_KEY_LEFT && currentFrame > 0)
+    currentFrame--;
+  animFrame = currentFrame;
+  if (isPlaying)
+    setPlaying(1);
+  glutPostRedisplay();
+}
+
+void keyboard(unsigned char key, int x, int y)
+{
+  if (key == 'b')
+  {
+    // Cycle 1 -> 4 -> 8 -> 16 samples
+    blurSamples = (blurSamples >= 16) ? 1 : (blurSamples == 1 ? 4 : blurSamples * 2);
+    pinnedBlur = 1;
+    if (blurSamples > 1 && !hasAccum)
+      printf("Motion blur unavailable: no accumulation buffer\n");
+    else
+      printf("Motion blur: %d samples\n", blurSamples);
+  }
+  else if (key == ' ')
+  {
+    setPlaying(!isPlaying);
+  }
+  else if (key == 'l')
+  {
+    latchCadence = !latchCadence;
+    printf("Cadence: %s\n", latchCadence ? "latched 24 fps" : "interpolated");
+  }
+  else if (key == 'h')
+  {
+    showShadow = !showShadow;
+    pinnedShadow = 1;
+  }
+  else if (key == 'v')
+  {
+    splitView = !splitView;
+  }
+  else if (key == 'x')
+  {
+    // The pose on screen, which may lie between 24 fps samples
+    exportVectorFrame(animFrame);
+    printf("Exported frame %06.2f\n", animFrame);
+  }
+  else if (key == 'X')
+  {
+    exportAllFrames();
+  }
+  else if (key == 'g')
+  {
+    governorEnabled = !governorEnabled;
+    printf("Governor: %s (target %.0f fps, level %s)%s%s\n", governorEnabled ? "on" : "off", targetFps,
+           qualityLevels[qualityLevel].name, pinnedKnobs()[0] ? ", pinned:" : "", pinnedKnobs());
+  }
+  else if (key == 'G')
+  {
+    // Cycle 24 -> 30 -> 60 fps
+    targetFps = (targetFps < 30.0f) ? 30.0f : (targetFps < 60.0f ? 60.0f : 24.0f);
+    printf("Governor target: %.0f fps\n", targetFps);
+  }
+  else if (key == 'w')
+  {
+    glowEnabled = !glowEnabled;
+    pinnedGlow = 1;
+  }
+  else if (key == 'p')
+  {
+    exportRasterFrame(animFrame);
+    printf("Exported frame %06.2f\n", animFrame);
+  }
+  else if (key == 'P')
+  {
+    for (int f = 0; f < MAX_FRAMES; f++)
+      exportRasterFrame(f);
+    printf("Exported %d frames\n", MAX_FRAMES);
+  }
+  else if (key == 'c')
+  {
+    crowdMode = !crowdMode;
+  }
+  else if (key == 't')
+  {
+    if (traceEnabled)
+      stopTrace();
+    else
+      startTrace();
+  }
+  glutPostRedisplay();
+}
+
+void init()
+{
+  glClearColor(0.0, 0.0, 0.0, 1.0);
+  glEnable(GL_DEPTH_TEST);
+  GLint stencilBits = 0;
+  glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+  hasStencil = stencilBits > 0;
+  GLint accumBits = 0;
+  glGetIntegerv(GL_ACCUM_RED_BITS, &accumBits);
+  hasAccum = accumBits > 0;
+  GLint sampleBuffers = 0;
+  glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+  hasMultisample = sampleBuffers > 0;
+  const char *glVersion = (const char *)glGetString(GL_VERSION);
+  const char *glExtensions = (const char *)glGetString(GL_EXTENSIONS);
+  hasNPOT = (glVersion && atoi(glVersion) >= 2) ||
+            (glExtensions && strstr(glExtensions, "GL_ARB_texture_non_power_of_two"));
+  hasPBO = (glVersion && atof(glVersion) >= 2.1) ||
+           (glExtensions && strstr(glExtensions, "GL_ARB_pixel_buffer_object"));
+  hasTimerQuery = (glVersion && atof(glVersion) >= 3.3) ||
+                  (glExtensions && strstr(glExtensions, "GL_ARB_timer_query"));
+  if (hasMultisample)
+    glDisable(GL_MULTISAMPLE); // Only the governor's higher levels turn it on
+  tess = gluNewTess();
+  gluTessCallback(tess, GLU_TESS_BEGIN, (void(CALLBACK *)())tessBeginCB);
+  gluTessCallback(tess, GLU_TESS_END, (void(CALLBACK *)())tessEndCB);
+  gluTessCallback(tess, GLU_TESS_VERTEX, (void(CALLBACK *)())tessVertexCB);
+  gluTessCallback(tess, GLU_TESS_COMBINE, (void(CALLBACK *)())tessCombineCB);
+  gluTessCallback(tess, GLU_TESS_EDGE_FLAG, (void(CALLBACK *)())tessEdgeFlagCB);
+  gluTessProperty(tess, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
+
+  // Bake both passes once
+  traceBegin("bake");
+  isWireframe = 0;
+  drawRecognizer();
+  isWireframe = 1;
+  drawRecognizer();
+  isWireframe = 0;
+  traceEnd("bake");
+
+  buildMeshLists();
+  buildStaticScene();
+}
+
+// Projection is set per view in drawScene
+void reshape(int w, int h)
+{
+  if (h == 0)
+    h = 1;
+  winW = w;
+  winH = h;
+  glViewport(0, 0, w, h);
+}
+
+// bench.c includes this file for its kernels and brings its own main
+#ifndef RECOGNIZER_NO_MAIN
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--trace") == 0)
+    {
+      startTrace();
+      atexit(stopTrace);
+    }
+    else if (strcmp(argv[i], "--crowd-bench") == 0)
+    {
+      return crowdBenchmark() ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--glow-bench") == 0)
+    {
+      return glowBenchmark() ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--cpu-glow") == 0)
+    {
+      cpuGlowExport = 1;
+    }
+    else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+    {
+      shmName = argv[++i];
+    }
+    else if (strcmp(argv[i], "--shm-consume") == 0 && i + 1 < argc)
+    {
+      return shmConsume(argv[++i]);
+    }
+  }
+  glutInit(&argc, argv);
+  // Ask for the optional buffers first and fall back to the plain visual
+  unsigned int baseMode = GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL;
+  unsigned int extraModes[] = {GLUT_ACCUM | GLUT_MULTISAMPLE, GLUT_ACCUM, GLUT_MULTISAMPLE, 0};
+  for (int i = 0; i < 4; i++)
+  {
+    glutInitDisplayMode(baseMode | extraModes[i]);
+    if (extraModes[i] == 0 || glutGet(GLUT_DISPLAY_MODE_POSSIBLE))
+      break;
+  }
+  glutInitWindowSize(winW, winH);
+  glutCreateWindow("Tron: Recognizer");
+  init();
+  if (shmName && !shmOpen(shmName, winW, winH))
+    return 1;
+  glutDisplayFunc(display);
+  glutReshapeFunc(reshape);
+  glutSpecialFunc(specialKeys);
+  glutKeyboardFunc(keyboard);
+#ifdef FREEGLUT
+  glutCloseFunc(shmClose); // While the context still exists
+#endif
+  glutMainLoop();
+  gluDeleteTess(tess);
+  return 0;
+}
+#endif